@@ -0,0 +1,164 @@
+#include "benchmark/benchmark.h"
+#include "src/LongNum.hpp"
+#include "src/Pi.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Benchmarks of the LongNum operators over operand sizes from one limb to a million limbs.
+// Every size runs twice: as an integer (second argument 0) and with half of the limbs after the
+// point (second argument 1). `make bench` writes the results to JSON, `make bench-compare` checks
+// them against a saved baseline
+
+namespace {
+
+constexpr int64_t MAX_LIMBS = 1 << 20;
+
+// Random number of the given number of limbs, the same for the same seed
+LongNum randomNumber(int64_t limbs, bool fractional, uint64_t seed) {
+    static const char hex[] = "0123456789abcdef";
+    std::mt19937_64 random(seed);
+    const int64_t fractionLimbs = fractional ? limbs / 2 : 0;
+    std::string digits;
+    digits.reserve(limbs * 8 + 1);
+    digits += hex[1 + random() % 15];
+    for (int64_t i = 1; i < limbs * 8; i++) {
+        if (i == (limbs - fractionLimbs) * 8) {
+            digits += '.';
+        }
+        digits += hex[random() % 16];
+    }
+    return LongNum::fromHex(digits, static_cast<uint32_t>(fractionLimbs * 32));
+}
+
+void sizes(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"limbs", "fractional"});
+    for (int64_t limbs = 1; limbs <= MAX_LIMBS; limbs *= 16) {
+        b->Args({limbs, 0});
+        b->Args({limbs, 1});
+    }
+    b->Unit(benchmark::kMicrosecond);
+}
+
+void setLimbs(benchmark::State& state) {
+    state.counters["limbs"] = static_cast<double>(state.range(0));
+}
+
+}
+
+// ****** Operators ******
+
+static void Add(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    const LongNum y = randomNumber(state.range(0), state.range(1), 2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x + y);
+    }
+    setLimbs(state);
+}
+BENCHMARK(Add)->Apply(sizes);
+
+static void Subtract(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    const LongNum y = randomNumber(state.range(0), state.range(1), 2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x - y);
+    }
+    setLimbs(state);
+}
+BENCHMARK(Subtract)->Apply(sizes);
+
+static void Multiply(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    const LongNum y = randomNumber(state.range(0), state.range(1), 2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x * y);
+    }
+    setLimbs(state);
+}
+BENCHMARK(Multiply)->Apply(sizes);
+
+// Dividend of the given size by a divisor of half of it
+static void Divide(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    const LongNum y = randomNumber(std::max<int64_t>(state.range(0) / 2, 1), state.range(1), 2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x / y);
+    }
+    setLimbs(state);
+}
+BENCHMARK(Divide)->Apply(sizes);
+
+static void ShiftLeft(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x << 77);
+    }
+    setLimbs(state);
+}
+BENCHMARK(ShiftLeft)->Apply(sizes);
+
+static void ShiftRight(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x >> 77);
+    }
+    setLimbs(state);
+}
+BENCHMARK(ShiftRight)->Apply(sizes);
+
+// Numbers that differ only in the lowest limb, so every limb is compared
+static void Compare(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    const LongNum y = x + (LongNum(1LL).withPrecision(x.getPrecision()) >> x.getPrecision());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x < y);
+    }
+    setLimbs(state);
+}
+BENCHMARK(Compare)->Apply(sizes);
+
+// 3 to the power that makes the result about the given number of limbs
+static void Pow(benchmark::State& state) {
+    const uint32_t precision = state.range(1) ? static_cast<uint32_t>(state.range(0) / 2 * 32) : 0;
+    const LongNum base = LongNum(3LL).withPrecision(precision);
+    const auto power = static_cast<uint32_t>(state.range(0) * 32 / std::log2(3.0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base.pow(power));
+    }
+    setLimbs(state);
+}
+BENCHMARK(Pow)->Apply(sizes);
+
+static void Sqrt(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x.sqrt());
+    }
+    setLimbs(state);
+}
+BENCHMARK(Sqrt)->Apply(sizes);
+
+static void ToString(benchmark::State& state) {
+    const LongNum x = randomNumber(state.range(0), state.range(1), 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x.toString());
+    }
+    setLimbs(state);
+}
+BENCHMARK(ToString)->Apply(sizes);
+
+// ****** End to end ******
+
+// Decimal digits of pi, computed and printed like calculate-pi does
+static void Pi(benchmark::State& state) {
+    const auto digits = static_cast<uint32_t>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(calculate_pi(std::max(380u, digits * 69 / 20 + 1)).toString(digits));
+    }
+}
+BENCHMARK(Pi)->ArgName("digits")->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
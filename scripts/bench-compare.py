@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# Compares two Google Benchmark JSON files (from `make bench`) and prints the change of the real
+# time of every benchmark present in both. Exits with status 1 if any benchmark got slower than
+# the baseline by more than the threshold (in percent).
+# Usage: bench-compare.py BASELINE.json CURRENT.json [--threshold PERCENT]
+import argparse
+import json
+import sys
+
+UNITS = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1.0}
+
+
+def load(path):
+    """Seconds per iteration by benchmark name, the median if the run has repetitions"""
+    with open(path) as file:
+        benchmarks = json.load(file)["benchmarks"]
+    times = {}
+    medians = {}
+    for benchmark in benchmarks:
+        if benchmark.get("error_occurred"):
+            continue
+        seconds = benchmark["real_time"] * UNITS[benchmark.get("time_unit", "ns")]
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") == "median":
+                medians[benchmark["run_name"]] = seconds
+        else:
+            times.setdefault(benchmark.get("run_name", benchmark["name"]), seconds)
+    times.update(medians)
+    return times
+
+
+def format_time(seconds):
+    for unit in ("s", "ms", "us"):
+        if seconds >= UNITS[unit]:
+            return "%.3f %s" % (seconds / UNITS[unit], unit)
+    return "%.1f ns" % (seconds / UNITS["ns"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare benchmark results with a baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="slowdown in percent that counts as a regression (default 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    names = [name for name in current if name in baseline]
+    if not names:
+        print("No common benchmarks", file=sys.stderr)
+        return 1
+
+    width = max(len(name) for name in names)
+    print("%-*s %12s %12s %9s" % (width, "benchmark", "baseline", "current", "change"))
+    regressions = []
+    for name in names:
+        change = (current[name] / baseline[name] - 1) * 100 if baseline[name] > 0 else 0.0
+        mark = ""
+        if change > args.threshold:
+            regressions.append(name)
+            mark = "  REGRESSION"
+        print("%-*s %12s %12s %+8.1f%%%s" % (width, name, format_time(baseline[name]),
+                                            format_time(current[name]), change, mark))
+
+    missing = [name for name in baseline if name not in current]
+    if missing:
+        print("\n%d benchmarks of the baseline were not run" % len(missing))
+    if regressions:
+        print("\n%d of %d benchmarks are slower than the baseline by more than %g%%"
+              % (len(regressions), len(names), args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
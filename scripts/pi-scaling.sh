@@ -0,0 +1,38 @@
+#!/bin/sh
+# Runs calculate-pi with 1, 2, 4, ... threads up to the number of cores and prints the wall
+# time and the speedup over a single thread. All runs must print the same digits.
+# Usage: pi-scaling.sh path/to/calculate-pi [PRECISION]
+set -e
+
+binary=${1:?path to calculate-pi}
+precision=${2:-100000}
+cores=$(nproc 2>/dev/null || getconf _NPROCESSORS_ONLN)
+reference=$(mktemp)
+output=$(mktemp)
+trap 'rm -f "$reference" "$output"' EXIT
+
+now() {
+    date +%s.%N
+}
+
+printf "%d digits, %d cores\n" "$precision" "$cores"
+printf "%8s %10s %8s\n" threads seconds speedup
+threads=1
+base=
+while :; do
+    start=$(now)
+    "$binary" --threads "$threads" "$precision" > "$output"
+    end=$(now)
+    seconds=$(awk "BEGIN { print $end - $start }")
+    if [ -z "$base" ]; then
+        base=$seconds
+        cp "$output" "$reference"
+    elif ! cmp -s "$output" "$reference"; then
+        echo "Output with $threads threads differs from the single-threaded one" >&2
+        exit 1
+    fi
+    printf "%8d %10.2f %8.2f\n" "$threads" "$seconds" "$(awk "BEGIN { print $base / $seconds }")"
+    [ "$threads" -ge "$cores" ] && break
+    threads=$((threads * 2))
+    [ "$threads" -gt "$cores" ] && threads=$cores
+done
@@ -0,0 +1,69 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+#include "Stats.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace limbs {
+
+    // Memory resource for limb buffers created on this thread, null means plain operator new.
+    // LongNum::ScopedArena replaces it for the duration of a computation, parallel tasks inherit
+    // the resource of the thread that started them
+    inline thread_local std::pmr::memory_resource* currentResource = nullptr;
+
+    // Limb buffers start on a cache line, so vector loads from their start never straddle two
+    constexpr size_t CACHE_LINE = 64;
+
+    inline void* allocate(std::pmr::memory_resource* resource, size_t bytes, size_t alignment) {
+        stats::allocated(bytes);
+        return resource ? resource->allocate(bytes, alignment) : ::operator new(bytes, std::align_val_t(alignment));
+    }
+
+    inline void deallocate(std::pmr::memory_resource* resource, void* p, size_t bytes, size_t alignment) {
+        stats::released(bytes);
+        if (resource) {
+            resource->deallocate(p, bytes, alignment);
+        } else {
+            ::operator delete(p, std::align_val_t(alignment));
+        }
+    }
+
+    // Allocator bound to the current resource at construction, like std::pmr::polymorphic_allocator
+    // bound to a thread-local default instead of the global one
+    template <typename T>
+    class Allocator {
+    public:
+        using value_type = T;
+
+        Allocator() noexcept = default;
+        template <typename U>
+        Allocator(const Allocator<U>& other) noexcept : resource(other.resource) {}
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(limbs::allocate(resource, n * sizeof(T), CACHE_LINE));
+        }
+        void deallocate(T* p, size_t n) {
+            limbs::deallocate(resource, p, n * sizeof(T), CACHE_LINE);
+        }
+
+        template <typename U>
+        bool operator==(const Allocator<U>& other) const noexcept {
+            return resource == other.resource;
+        }
+
+    private:
+        template <typename U>
+        friend class Allocator;
+
+        std::pmr::memory_resource* resource = currentResource;
+    };
+
+    // Temporary limb arrays of the kernels
+    using Buffer = std::vector<uint32_t, Allocator<uint32_t>>;
+
+}
+
+#endif
@@ -0,0 +1,179 @@
+#include "Allocator.hpp"
+#include "LongNum.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// Memory resources behind LongNum::ScopedArena. Both carve memory out of large blocks that are
+// released together when the arena ends; the first block of the next arena on the same thread is
+// taken from a small cache, so short arenas in a loop do not go back to the system every time.
+// A mutex lets the pool threads working for the arena owner allocate from it too.
+
+namespace {
+
+constexpr size_t MIN_BLOCK = size_t(64) << 10;
+constexpr size_t MAX_CACHED_BLOCK = size_t(4) << 20;
+constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+
+struct Block {
+    Block* previous;
+    size_t size;
+};
+
+// One retired block per thread, reused as the first block of the next arena
+struct BlockCache {
+    Block* block = nullptr;
+
+    ~BlockCache() {
+        ::operator delete(block);
+    }
+};
+
+thread_local BlockCache cache;
+
+// Bump allocation from a chain of blocks
+class Region {
+public:
+    Region() = default;
+    Region(const Region&) = delete;
+    Region& operator=(const Region&) = delete;
+
+    ~Region() {
+        while (head) {
+            Block* previous = head->previous;
+            if (head->size <= MAX_CACHED_BLOCK && (!cache.block || cache.block->size < head->size)) {
+                std::swap(head, cache.block);
+            }
+            ::operator delete(head);
+            head = previous;
+        }
+    }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        char* p = align(cursor, alignment);
+        if (!head || p > end || bytes > static_cast<size_t>(end - p)) {
+            addBlock(bytes + alignment);
+            p = align(cursor, alignment);
+        }
+        cursor = p + bytes;
+        return p;
+    }
+
+    // Gives back the most recent allocation, anything else stays until the region ends
+    void release(void* p, size_t bytes) {
+        if (static_cast<char*>(p) + bytes == cursor) {
+            cursor = static_cast<char*>(p);
+        }
+    }
+
+private:
+    Block* head = nullptr;
+    char* cursor = nullptr;
+    char* end = nullptr;
+
+    static char* align(char* p, size_t alignment) {
+        const uintptr_t value = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((value + alignment - 1) & ~(alignment - 1));
+    }
+
+    void addBlock(size_t bytes) {
+        const size_t size = std::max({bytes + sizeof(Block), MIN_BLOCK, head ? 2 * head->size : 0});
+        Block* block;
+        if (cache.block && cache.block->size >= size) {
+            block = std::exchange(cache.block, nullptr);
+        } else {
+            block = static_cast<Block*>(::operator new(size));
+            block->size = size;
+        }
+        block->previous = head;
+        head = block;
+        cursor = reinterpret_cast<char*>(block + 1);
+        end = reinterpret_cast<char*>(block) + block->size;
+    }
+};
+
+class BumpResource : public std::pmr::memory_resource {
+private:
+    Region region;
+    std::mutex mutex;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        std::lock_guard lock(mutex);
+        return region.allocate(bytes, std::max(alignment, ALIGNMENT));
+    }
+    void do_deallocate(void* p, size_t bytes, size_t) override {
+        std::lock_guard lock(mutex);
+        region.release(p, bytes);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Power-of-two size classes with free lists, larger requests go straight to operator new
+class PoolResource : public std::pmr::memory_resource {
+private:
+    static constexpr unsigned MIN_CLASS = 4;
+    static constexpr unsigned MAX_CLASS = 20;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    Region region;
+    FreeBlock* freeLists[MAX_CLASS + 1] = {};
+    std::mutex mutex;
+
+    static unsigned sizeClass(size_t bytes) {
+        return std::max<unsigned>(MIN_CLASS, std::bit_width(bytes - 1));
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        const unsigned c = sizeClass(std::max(bytes, alignment));
+        if (c > MAX_CLASS || alignment > limbs::CACHE_LINE) {
+            return ::operator new(bytes, std::align_val_t(std::max(alignment, ALIGNMENT)));
+        }
+        std::lock_guard lock(mutex);
+        if (FreeBlock* block = freeLists[c]) {
+            freeLists[c] = block->next;
+            return block;
+        }
+        // Blocks of a class are aligned to their size up to a cache line, so any of them
+        // suits any request of the class
+        return region.allocate(size_t(1) << c, std::clamp(size_t(1) << c, ALIGNMENT, limbs::CACHE_LINE));
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        const unsigned c = sizeClass(std::max(bytes, alignment));
+        if (c > MAX_CLASS || alignment > limbs::CACHE_LINE) {
+            ::operator delete(p, std::align_val_t(std::max(alignment, ALIGNMENT)));
+            return;
+        }
+        std::lock_guard lock(mutex);
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = freeLists[c];
+        freeLists[c] = block;
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+}
+
+LongNum::ScopedArena::ScopedArena(Kind kind) : previous(limbs::currentResource) {
+    if (kind == Kind::Bump) {
+        resource = std::make_unique<BumpResource>();
+    } else {
+        resource = std::make_unique<PoolResource>();
+    }
+    limbs::currentResource = resource.get();
+}
+
+LongNum::ScopedArena::~ScopedArena() {
+    limbs::currentResource = previous;
+}
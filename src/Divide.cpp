@@ -0,0 +1,259 @@
+#include "Limbs.hpp"
+#include "LongNum.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Integer division of limb arrays: Knuth's Algorithm D for small and unbalanced operands,
+// multiplication by a Newton reciprocal once both the divisor and the quotient have at least
+// LongNum::Thresholds::newtonDivision limbs.
+
+namespace {
+
+using Limbs = limbs::Buffer;
+
+using limbs::addInto;
+using limbs::subInto;
+using limbs::significantSize;
+
+int compare(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    na = significantSize(a, na);
+    nb = significantSize(b, nb);
+    if (na != nb) {
+        return na < nb ? -1 : 1;
+    }
+    return limbs::cmp(a, b, na);
+}
+
+Limbs product(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    Limbs result(na + nb);
+    limbs::mul(result.data(), a, na, b, nb);
+    return result;
+}
+
+// x << shift limbs followed by a bit shift, out has n + extra + 1 limbs
+Limbs shifted(const uint32_t* x, size_t n, size_t extra, unsigned bits) {
+    Limbs result(n + extra + 1, 0);
+    result[extra + n] = limbs::lshift(result.data() + extra, x, n, bits);
+    return result;
+}
+
+// Knuth, TAOCP vol. 2, 4.3.1, Algorithm D. n >= 2
+void divRemKnuth(uint32_t* q, uint32_t* r, const uint32_t* a, size_t m, const uint32_t* b, size_t n) {
+    const unsigned s = std::countl_zero(b[n - 1]);
+    const Limbs bn = shifted(b, n, 0, s);
+    Limbs an = shifted(a, m, 0, s);
+    const uint64_t top = bn[n - 1], next = bn[n - 2];
+
+    for (size_t j = m - n + 1; j-- > 0;) {
+        const uint64_t num = (static_cast<uint64_t>(an[j + n]) << 32) | an[j + n - 1];
+        uint64_t qhat = num / top;
+        uint64_t rhat = num % top;
+        while (qhat >> 32 || qhat * next > ((rhat << 32) | an[j + n - 2])) {
+            qhat--;
+            rhat += top;
+            if (rhat >> 32) {
+                break;
+            }
+        }
+
+        const uint32_t borrow = limbs::submul1(an.data() + j, bn.data(), n, static_cast<uint32_t>(qhat));
+        const bool negative = an[j + n] < borrow;
+        an[j + n] -= borrow;
+
+        if (negative) {
+            qhat--;
+            an[j + n] += limbs::addN(an.data() + j, an.data() + j, bn.data(), n);
+        }
+        if (q) {
+            q[j] = static_cast<uint32_t>(qhat);
+        }
+    }
+
+    if (r) {
+        limbs::rshift(an.data(), an.data(), n + 1, s);
+        std::copy(an.begin(), an.begin() + n, r);
+    }
+}
+
+// floor(B^(2n) / d) for d of n limbs with the top bit set, n + 1 limbs.
+// The reciprocal of the top half is refined with one Newton step x += x * (B^2n - d * x) / B^2n.
+// Starting below the true value keeps every intermediate non-negative
+Limbs reciprocal(const uint32_t* d, size_t n) {
+    if (n < LongNum::getThresholds().newtonDivision) {
+        Limbs num(2 * n + 1, 0);
+        num[2 * n] = 1;
+        Limbs v(n + 2);
+        divRemKnuth(v.data(), nullptr, num.data(), num.size(), d, n);
+        v.resize(n + 1);
+        return v;
+    }
+    const size_t h = n / 2 + 1;
+    // floor(B^2h / d_top) - 5 underestimates B^2h / (d_top + 1), so y * B^(n-h) <= B^2n / d
+    Limbs y = reciprocal(d + n - h, h);
+    const uint32_t five = 5;
+    subInto(y.data(), y.size(), &five, 1);
+
+    // e = B^(n+h) - d * y, a small non-negative number
+    const Limbs dy = product(d, n, y.data(), y.size());
+    Limbs e(n + h + 1, 0);
+    e[n + h] = 1;
+    subInto(e.data(), e.size(), dy.data(), significantSize(dy.data(), dy.size()));
+
+    // x = y * B^(n-h) + floor(y * e / B^2h)
+    Limbs x(n + 1, 0);
+    std::copy(y.begin(), y.end(), x.begin() + (n - h));
+    const Limbs ye = product(y.data(), y.size(), e.data(), significantSize(e.data(), e.size()));
+    if (ye.size() > 2 * h) {
+        addInto(x.data(), x.size(), ye.data() + 2 * h, significantSize(ye.data() + 2 * h, ye.size() - 2 * h));
+    }
+
+    // x is at most a couple of units too small
+    const Limbs dx = product(d, n, x.data(), x.size());
+    Limbs rem(2 * n + 1, 0);
+    rem[2 * n] = 1;
+    subInto(rem.data(), rem.size(), dx.data(), significantSize(dx.data(), dx.size()));
+    const uint32_t one = 1;
+    while (compare(rem.data(), rem.size(), d, n) >= 0) {
+        subInto(rem.data(), rem.size(), d, n);
+        addInto(x.data(), x.size(), &one, 1);
+    }
+    return x;
+}
+
+// floor(num / d) and num mod d for a normalised d of n limbs, its reciprocal v and num of at most
+// 2n limbs. The estimate floor(num * v / B^2n) is at most two units too small
+std::pair<Limbs, Limbs> divRemByReciprocal(Limbs num, const uint32_t* d, size_t n, const Limbs& v) {
+    const Limbs numV = product(num.data(), num.size(), v.data(), v.size());
+    Limbs quotient(numV.begin() + 2 * n, numV.end());
+    const Limbs qd = product(quotient.data(), quotient.size(), d, n);
+    subInto(num.data(), num.size(), qd.data(), significantSize(qd.data(), qd.size()));
+    const uint32_t one = 1;
+    while (compare(num.data(), num.size(), d, n) >= 0) {
+        subInto(num.data(), num.size(), d, n);
+        addInto(quotient.data(), quotient.size(), &one, 1);
+    }
+    return {std::move(quotient), std::move(num)};
+}
+
+void divRemNewton(uint32_t* q, uint32_t* r, const uint32_t* a, size_t m, const uint32_t* b, size_t n) {
+    // Normalise the divisor and pad both operands with k zero limbs so that the dividend
+    // has at most twice as many limbs as the divisor
+    const unsigned s = std::countl_zero(b[n - 1]);
+    const size_t k = m + 1 > 2 * n ? m + 1 - 2 * n : 0;
+    Limbs d = shifted(b, n, k, s);
+    d.pop_back();
+    const size_t nd = d.size();
+
+    auto [quotient, rem] = divRemByReciprocal(shifted(a, m, k, s), d.data(), nd, reciprocal(d.data(), nd));
+
+    if (q) {
+        quotient.resize(std::max(quotient.size(), m - n + 1), 0);
+        std::copy(quotient.begin(), quotient.begin() + (m - n + 1), q);
+    }
+    if (r) {
+        for (size_t i = 0; i < n; i++) {
+            r[i] = s ? (rem[k + i] >> s) | (rem[k + i + 1] << (32 - s)) : rem[k + i];
+        }
+    }
+}
+
+// Quotient limb of u1 * B + u0 by a normalised d with u1 < d, using inverse = floor((B^2 - 1) / d) - B.
+// Möller and Granlund, "Improved division by invariant integers", algorithm 4
+uint32_t divPreinverted(uint32_t u1, uint32_t u0, uint32_t d, uint32_t inverse, uint32_t& rem) {
+    // The estimate is computed modulo B^2, its high limb may wrap around
+    const uint64_t estimate = static_cast<uint64_t>(inverse) * u1 + ((static_cast<uint64_t>(u1) << 32) | u0);
+    uint32_t q = static_cast<uint32_t>(estimate >> 32) + 1;
+    uint32_t r = u0 - q * d;
+    if (r > static_cast<uint32_t>(estimate)) {
+        q--;
+        r += d;
+    }
+    if (r >= d) {
+        q++;
+        r -= d;
+    }
+    rem = r;
+    return q;
+}
+
+}
+
+limbs::Divisor::Divisor(const uint32_t* b, size_t nb)
+    : divisor(b, b + nb), shift(std::countl_zero(b[nb - 1])), normalized(shifted(b, nb, 0, shift)) {
+    normalized.pop_back();
+    if (nb == 1) {
+        inverse = static_cast<uint32_t>(UINT64_MAX / normalized[0]);
+    } else if (nb >= LongNum::getThresholds().newtonDivision) {
+        reciprocal = ::reciprocal(normalized.data(), nb);
+    }
+}
+
+void limbs::Divisor::divRem(uint32_t* q, uint32_t* r, const uint32_t* a, size_t na) const {
+    const size_t n = divisor.size();
+    if (n == 1) {
+        stats::Scope scope(stats::Tier::LongDivision, na + 1);
+        // Divides a << shift, whose limbs are formed on the fly, by the normalised divisor
+        const uint32_t d = normalized[0];
+        uint32_t rem = shift ? a[na - 1] >> (32 - shift) : 0;
+        for (size_t i = na; i-- > 0;) {
+            const uint32_t limb = shift && i ? (a[i] << shift) | (a[i - 1] >> (32 - shift)) : a[i] << shift;
+            const uint32_t digit = divPreinverted(rem, limb, d, inverse, rem);
+            if (q) {
+                q[i] = digit;
+            }
+        }
+        if (r) {
+            r[0] = rem >> shift;
+        }
+        return;
+    }
+    if (reciprocal.empty() || na - n + 1 < LongNum::getThresholds().newtonDivision) {
+        limbs::divRem(q, r, a, na, divisor.data(), n);
+        return;
+    }
+    // Long division of the normalised dividend: the top part has n + 1 to 2n limbs, every
+    // further step divides the running remainder followed by the next n limbs
+    stats::Scope scope(stats::Tier::NewtonDivision, na + n);
+    const Limbs an = shifted(a, na, 0, shift);
+    const size_t quotientSize = na - n + 1;
+    size_t block = (an.size() + n - 1) / n - 2;
+    auto [quotient, rem] = divRemByReciprocal(Limbs(an.begin() + block * n, an.end()), normalized.data(), n, reciprocal);
+    if (q) {
+        std::copy(quotient.begin(), quotient.begin() + (quotientSize - block * n), q + block * n);
+    }
+    while (block-- > 0) {
+        Limbs num(2 * n);
+        std::copy(an.begin() + block * n, an.begin() + (block + 1) * n, num.begin());
+        std::copy(rem.begin(), rem.begin() + n, num.begin() + n);
+        std::tie(quotient, rem) = divRemByReciprocal(std::move(num), normalized.data(), n, reciprocal);
+        if (q) {
+            std::copy(quotient.begin(), quotient.begin() + n, q + block * n);
+        }
+    }
+    if (r) {
+        limbs::rshift(r, rem.data(), n, shift);
+    }
+}
+
+void limbs::divRem(uint32_t* q, uint32_t* r, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (nb == 1) {
+        stats::Scope scope(stats::Tier::LongDivision, na + 1);
+        const uint32_t rem = limbs::divRem1(q, a, na, b[0]);
+        if (r) {
+            r[0] = rem;
+        }
+        return;
+    }
+    const size_t threshold = LongNum::getThresholds().newtonDivision;
+    if (nb >= threshold && na - nb + 1 >= threshold) {
+        stats::Scope scope(stats::Tier::NewtonDivision, na + nb);
+        divRemNewton(q, r, a, na, b, nb);
+    } else {
+        stats::Scope scope(stats::Tier::LongDivision, na + nb);
+        divRemKnuth(q, r, a, na, b, nb);
+    }
+}
@@ -0,0 +1,133 @@
+#include "Expression.hpp"
+#include <utility>
+
+// Evaluation of the sums of products recorded by the expression templates. A product is computed
+// left to right like the operators would: runs of integer factors are multiplied as machine words
+// while they fit, products of two numbers go to the other of two buffers.
+
+using expr::Factor;
+using expr::Term;
+
+class expr::Evaluator {
+public:
+    LongNum scratch = 0LL;
+
+    // dest = the product of the term. dest must not be one of its factors
+    void product(LongNum& dest, const Term& term);
+
+    // out += the product of the term. A number times an integer of at most one limb is added
+    // to the limbs of out directly, other terms go through a temporary
+    void add(LongNum& out, const Term& term);
+};
+
+namespace {
+
+// Product of the integer factors in [first, last) that fits in 64 bits, advances first past them
+bool foldIntegers(const Factor*& first, const Factor* last, uint64_t& magnitude, bool& negative) {
+    magnitude = 1;
+    negative = false;
+    bool found = false;
+    for (; first != last && !first->number; first++) {
+        uint64_t next;
+        if (found && __builtin_mul_overflow(magnitude, first->magnitude, &next)) {
+            break;
+        }
+        magnitude = found ? next : first->magnitude;
+        negative ^= first->negative;
+        found = true;
+    }
+    return found;
+}
+
+}
+
+void expr::Evaluator::product(LongNum& dest, const Term& term) {
+    const Factor* factor = term.factors;
+    const Factor* const last = term.factors + term.count;
+    // The first number is only copied once an integer factor needs to multiply it in place
+    const LongNum* pending = nullptr;
+    bool started = false;
+    while (factor != last) {
+        uint64_t magnitude;
+        bool negative;
+        if (foldIntegers(factor, last, magnitude, negative)) {
+            if (pending) {
+                dest = *pending;
+                pending = nullptr;
+            }
+            if (started) {
+                dest.mulSmall(magnitude, negative);
+            } else {
+                dest = LongNum(static_cast<unsigned long long>(magnitude));
+                dest.isNegative = negative && magnitude != 0;
+                started = true;
+            }
+            continue;
+        }
+        const LongNum& number = *factor->number;
+        factor++;
+        if (!started) {
+            pending = &number;
+            started = true;
+            continue;
+        }
+        const LongNum& left = pending ? *pending : dest;
+        LongNum::multiply(scratch, left, number, std::max(left.precision, number.precision));
+        std::swap(dest, scratch);
+        pending = nullptr;
+    }
+    if (pending) {
+        dest = *pending;
+    }
+    if (term.negative && !dest.isZero()) {
+        dest.isNegative = !dest.isNegative;
+    }
+}
+
+void expr::Evaluator::add(LongNum& out, const Term& term) {
+    // A single number with integer factors before or after it
+    const Factor* factor = term.factors;
+    const Factor* const last = term.factors + term.count;
+    uint64_t before, after;
+    bool negativeBefore, negativeAfter;
+    foldIntegers(factor, last, before, negativeBefore);
+    if (factor != last && factor->number && factor->number != &out) {
+        const LongNum& number = *factor->number;
+        factor++;
+        foldIntegers(factor, last, after, negativeAfter);
+        uint64_t magnitude;
+        if (factor == last && !__builtin_mul_overflow(before, after, &magnitude) && magnitude <= UINT32_MAX) {
+            const bool negative = term.negative != (negativeBefore != negativeAfter);
+            if (magnitude == 1) {
+                if (negative) {
+                    out -= number;
+                } else {
+                    out += number;
+                }
+            } else {
+                out.addMulSmall(number, static_cast<uint32_t>(magnitude), negative);
+            }
+            return;
+        }
+    }
+    LongNum value = 0LL;
+    product(value, term);
+    out += value;
+}
+
+LongNum expr::evaluate(const Term* terms, size_t count) {
+    Evaluator evaluator;
+    LongNum result = 0LL;
+    evaluator.product(result, terms[0]);
+    for (size_t i = 1; i < count; i++) {
+        evaluator.add(result, terms[i]);
+    }
+    return result;
+}
+
+void expr::accumulate(LongNum& out, const Term* terms, size_t count) {
+    Evaluator evaluator;
+    for (size_t i = 0; i < count; i++) {
+        evaluator.add(out, terms[i]);
+    }
+}
@@ -0,0 +1,203 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+#include "LongNum.hpp"
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Opt-in expression templates over LongNum. Starting a chain with expr::lazy() makes `*`, `+` and `-`
+// record the operands instead of computing intermediate numbers:
+//
+//     LongNum t = expr::lazy(a) * 13591409 + expr::lazy(b) * 545140134;
+//     x += expr::lazy(y) * z * 3;
+//
+// The whole sum of products is evaluated when it is converted to a LongNum or added to one. Adjacent
+// integer factors are multiplied as machine words, a number times an integer that fits a limb is
+// added to the destination limbs in one multiply-accumulate pass, and products of several numbers
+// alternate between two buffers. The results are the same as with the plain operators, evaluated
+// left to right. Expressions refer to their operands, so they must be used within the statement
+// that creates them: do not keep them in `auto` variables
+namespace expr {
+
+    // A factor of a product: a number, or an integer with `number` null
+    struct Factor {
+        const LongNum* number;
+        uint64_t magnitude;
+        bool negative;
+    };
+
+    struct Term {
+        const Factor* factors;
+        size_t count;
+        bool negative;
+    };
+
+    template <typename T>
+    concept Operand = std::same_as<std::remove_cvref_t<T>, LongNum> || NativeInteger<std::remove_cvref_t<T>>;
+
+    inline Factor factor(const LongNum& number) {
+        return {&number, 0, false};
+    }
+
+    template <NativeInteger T>
+    Factor factor(T value) {
+        const bool negative = std::cmp_less(value, 0);
+        return {nullptr, negative ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value), negative};
+    }
+
+    // Product of N factors, possibly negated
+    template <size_t N>
+    struct Product {
+        std::array<Factor, N> factors;
+        bool negative = false;
+
+        Term term(void) const {
+            return {factors.data(), N, negative};
+        }
+
+        operator LongNum() const {
+            const Term t = term();
+            return evaluate(&t, 1);
+        }
+    };
+
+    // Sum of products with N[i] factors each
+    template <size_t... N>
+    struct Sum {
+        std::tuple<Product<N>...> products;
+
+        std::array<Term, sizeof...(N)> terms(void) const {
+            return std::apply([](const auto&... p) { return std::array<Term, sizeof...(N)>{p.term()...}; }, products);
+        }
+
+        operator LongNum() const {
+            const auto t = terms();
+            return evaluate(t.data(), t.size());
+        }
+    };
+
+    template <Operand T>
+    Product<1> lazy(const T& value) {
+        return {{factor(value)}};
+    }
+
+    template <typename T>
+    struct IsExpression : std::false_type {};
+    template <size_t N>
+    struct IsExpression<Product<N>> : std::true_type {};
+    template <size_t... N>
+    struct IsExpression<Sum<N...>> : std::true_type {};
+
+    template <typename T>
+    concept Expression = IsExpression<std::remove_cvref_t<T>>::value;
+
+    template <size_t N>
+    Product<N> operator-(Product<N> p) {
+        p.negative = !p.negative;
+        return p;
+    }
+
+    template <size_t N, size_t M>
+    Product<N + M> operator*(const Product<N>& lhs, const Product<M>& rhs) {
+        Product<N + M> result;
+        std::copy(lhs.factors.begin(), lhs.factors.end(), result.factors.begin());
+        std::copy(rhs.factors.begin(), rhs.factors.end(), result.factors.begin() + N);
+        result.negative = lhs.negative != rhs.negative;
+        return result;
+    }
+
+    template <size_t N, Operand T>
+    Product<N + 1> operator*(const Product<N>& lhs, const T& rhs) {
+        return lhs * lazy(rhs);
+    }
+
+    template <size_t N, Operand T>
+    Product<N + 1> operator*(const T& lhs, const Product<N>& rhs) {
+        return lazy(lhs) * rhs;
+    }
+
+    template <size_t N>
+    Sum<N> toSum(const Product<N>& p) {
+        return {{p}};
+    }
+
+    template <size_t... N>
+    const Sum<N...>& toSum(const Sum<N...>& s) {
+        return s;
+    }
+
+    template <Operand T>
+    Sum<1> toSum(const T& value) {
+        return {{lazy(value)}};
+    }
+
+    template <size_t... N>
+    Sum<N...> negated(Sum<N...> s) {
+        std::apply([](auto&... p) { ((p.negative = !p.negative), ...); }, s.products);
+        return s;
+    }
+
+    template <size_t... N, size_t... M>
+    Sum<N..., M...> concat(const Sum<N...>& lhs, const Sum<M...>& rhs) {
+        return {std::tuple_cat(lhs.products, rhs.products)};
+    }
+
+    template <typename L, typename R>
+        requires (Expression<L> || Expression<R>) && (Expression<L> || Operand<L>) && (Expression<R> || Operand<R>)
+    auto operator+(const L& lhs, const R& rhs) {
+        return concat(toSum(lhs), toSum(rhs));
+    }
+
+    template <typename L, typename R>
+        requires (Expression<L> || Expression<R>) && (Expression<L> || Operand<L>) && (Expression<R> || Operand<R>)
+    auto operator-(const L& lhs, const R& rhs) {
+        return concat(toSum(lhs), negated(toSum(rhs)));
+    }
+
+    // A temporary LongNum operand would otherwise match the rvalue overloads of LongNum through the
+    // conversion of the expression as well, which makes the call ambiguous. It lives until the end of
+    // the full expression, so it is referred to like any other operand
+    template <Expression E>
+    auto operator+(const E& lhs, LongNum&& rhs) {
+        return concat(toSum(lhs), toSum(rhs));
+    }
+
+    template <Expression E>
+    auto operator+(LongNum&& lhs, const E& rhs) {
+        return concat(toSum(lhs), toSum(rhs));
+    }
+
+    template <Expression E>
+    auto operator-(const E& lhs, LongNum&& rhs) {
+        return concat(toSum(lhs), negated(toSum(rhs)));
+    }
+
+    template <Expression E>
+    auto operator-(LongNum&& lhs, const E& rhs) {
+        return concat(toSum(lhs), negated(toSum(rhs)));
+    }
+
+    template <Expression E>
+    LongNum& operator+=(LongNum& out, const E& e) {
+        const auto sum = toSum(e);
+        const auto t = sum.terms();
+        accumulate(out, t.data(), t.size());
+        return out;
+    }
+
+    template <Expression E>
+    LongNum& operator-=(LongNum& out, const E& e) {
+        const auto sum = negated(toSum(e));
+        const auto t = sum.terms();
+        accumulate(out, t.data(), t.size());
+        return out;
+    }
+
+}
+
+#endif
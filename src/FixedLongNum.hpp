@@ -0,0 +1,411 @@
+#ifndef FIXED_LONG_NUM_H
+#define FIXED_LONG_NUM_H
+#include "LongNum.hpp"
+#include <array>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Fixed-point numbers with a precision known at compile time: IntBits integer bits, the sign bit
+// included, and FracBits fractional bits. The value times 2^FracBits is kept in two's complement in
+// an std::array of 64-bit words, so there is no precision field, no heap buffer and no alignment of
+// the operands, and every operation is constexpr over a fixed number of words. Like the built-in
+// integers, results wrap around modulo 2^(IntBits + FracBits). Products and quotients are truncated
+// toward zero like those of LongNum. Conversions to LongNum are exact, conversions from it drop the
+// bits below FracBits and throw std::out_of_range if the integer part does not fit
+template <unsigned IntBits, unsigned FracBits>
+class FixedLongNum {
+    static_assert(IntBits > 0, "The sign takes one of the integer bits");
+
+public:
+    static constexpr unsigned BITS = IntBits + FracBits;
+    static constexpr size_t WORDS = (BITS + 63) / 64;
+
+    constexpr FixedLongNum() = default;
+
+    template <NativeInteger T>
+    constexpr FixedLongNum(T value) {
+        words.fill(std::cmp_less(value, 0) ? UINT64_MAX : 0);
+        words[0] = static_cast<uint64_t>(value);
+        *this <<= FracBits;
+    }
+
+    explicit FixedLongNum(const LongNum& number);
+    explicit operator LongNum() const;
+
+    // The value times 2^FracBits in two's complement, sign-extended to whole words
+    constexpr const std::array<uint64_t, WORDS>& raw(void) const {
+        return words;
+    }
+    static constexpr FixedLongNum fromRaw(const std::array<uint64_t, WORDS>& raw) {
+        FixedLongNum result;
+        result.words = raw;
+        result.normalize();
+        return result;
+    }
+
+    constexpr bool isZero(void) const {
+        for (uint64_t word : words) {
+            if (word) {
+                return false;
+            }
+        }
+        return true;
+    }
+    constexpr int sign(void) const {
+        return isNegative() ? -1 : !isZero();
+    }
+    constexpr FixedLongNum abs(void) const {
+        return isNegative() ? -*this : *this;
+    }
+
+    std::string toString(unsigned decimalPrecision = UINT32_MAX) const {
+        return LongNum(*this).toString(decimalPrecision);
+    }
+
+    constexpr FixedLongNum operator-() const {
+        FixedLongNum result = *this;
+        result.negate();
+        result.normalize();
+        return result;
+    }
+    constexpr FixedLongNum operator+() const {
+        return *this;
+    }
+
+    constexpr FixedLongNum& operator+=(const FixedLongNum& other) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < WORDS; i++) {
+            const uint64_t sum = words[i] + other.words[i];
+            const uint64_t next = sum + carry;
+            carry = (sum < words[i]) | (next < sum);
+            words[i] = next;
+        }
+        normalize();
+        return *this;
+    }
+
+    constexpr FixedLongNum& operator-=(const FixedLongNum& other) {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < WORDS; i++) {
+            const uint64_t difference = words[i] - other.words[i];
+            const uint64_t next = difference - borrow;
+            borrow = (words[i] < other.words[i]) | (difference < borrow);
+            words[i] = next;
+        }
+        normalize();
+        return *this;
+    }
+
+    constexpr FixedLongNum& operator*=(const FixedLongNum& other) {
+        const bool negative = isNegative() != other.isNegative();
+        const std::array<uint64_t, WORDS> a = magnitude(), b = other.magnitude();
+        std::array<uint64_t, 2 * WORDS> product{};
+        for (size_t i = 0; i < WORDS; i++) {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < WORDS; j++) {
+                uint64_t high;
+                const uint64_t low = mulWide(a[i], b[j], high);
+                const uint64_t sum = product[i + j] + low;
+                const uint64_t next = sum + carry;
+                carry = high + (sum < low) + (next < sum);
+                product[i + j] = next;
+            }
+            product[i + WORDS] = carry;
+        }
+        // Bits [FracBits, FracBits + 64 * WORDS) of the product
+        constexpr size_t wordShift = FracBits / 64;
+        constexpr unsigned bitShift = FracBits % 64;
+        for (size_t i = 0; i < WORDS; i++) {
+            const uint64_t next = i + wordShift + 1 < 2 * WORDS ? product[i + wordShift + 1] : 0;
+            words[i] = bitShift ? (product[i + wordShift] >> bitShift) | (next << (64 - bitShift)) : product[i + wordShift];
+        }
+        if (negative) {
+            negate();
+        }
+        normalize();
+        return *this;
+    }
+
+    constexpr FixedLongNum& operator/=(const FixedLongNum& other) {
+        if (other.isZero()) {
+            throw std::invalid_argument("Division by zero");
+        }
+        const bool negative = isNegative() != other.isNegative();
+        // (|this| << FracBits) / |other| in 32-bit limbs
+        constexpr size_t LIMBS = 2 * WORDS;
+        constexpr size_t NUMERATOR = LIMBS + (FracBits + 31) / 32;
+        std::array<uint32_t, NUMERATOR + 1> u{};
+        std::array<uint32_t, LIMBS> v{};
+        const std::array<uint64_t, WORDS> a = magnitude(), b = other.magnitude();
+        for (size_t i = 0; i < LIMBS; i++) {
+            u[i] = static_cast<uint32_t>(a[i / 2] >> (32 * (i % 2)));
+            v[i] = static_cast<uint32_t>(b[i / 2] >> (32 * (i % 2)));
+        }
+        shiftLimbsLeft(u, FracBits);
+        size_t n = LIMBS;
+        while (v[n - 1] == 0) {
+            n--;
+        }
+        const std::array<uint32_t, NUMERATOR + 1> q = divideLimbs(u, NUMERATOR, v, n);
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i] = q[2 * i] | (static_cast<uint64_t>(q[2 * i + 1]) << 32);
+        }
+        if (negative) {
+            negate();
+        }
+        normalize();
+        return *this;
+    }
+
+    friend constexpr FixedLongNum operator+(FixedLongNum lnum, const FixedLongNum& rnum) {
+        return lnum += rnum;
+    }
+    friend constexpr FixedLongNum operator-(FixedLongNum lnum, const FixedLongNum& rnum) {
+        return lnum -= rnum;
+    }
+    friend constexpr FixedLongNum operator*(FixedLongNum lnum, const FixedLongNum& rnum) {
+        return lnum *= rnum;
+    }
+    friend constexpr FixedLongNum operator/(FixedLongNum lnum, const FixedLongNum& rnum) {
+        return lnum /= rnum;
+    }
+
+    friend constexpr bool operator==(const FixedLongNum& lnum, const FixedLongNum& rnum) = default;
+
+    friend constexpr std::strong_ordering operator<=>(const FixedLongNum& lnum, const FixedLongNum& rnum) {
+        if (lnum.isNegative() != rnum.isNegative()) {
+            return lnum.isNegative() ? std::strong_ordering::less : std::strong_ordering::greater;
+        }
+        // Two's complement of the same sign compares like unsigned numbers
+        for (size_t i = WORDS; i-- > 0;) {
+            if (lnum.words[i] != rnum.words[i]) {
+                return lnum.words[i] < rnum.words[i] ? std::strong_ordering::less : std::strong_ordering::greater;
+            }
+        }
+        return std::strong_ordering::equal;
+    }
+
+    constexpr FixedLongNum& operator<<=(unsigned shift) {
+        const size_t wordShift = shift / 64;
+        const unsigned bitShift = shift % 64;
+        for (size_t i = WORDS; i-- > 0;) {
+            const uint64_t word = i >= wordShift ? words[i - wordShift] : 0;
+            const uint64_t lower = i >= wordShift + 1 ? words[i - wordShift - 1] : 0;
+            words[i] = bitShift ? (word << bitShift) | (lower >> (64 - bitShift)) : word;
+        }
+        normalize();
+        return *this;
+    }
+
+    // Arithmetic shift, rounds toward minus infinity like >> of the built-in integers
+    constexpr FixedLongNum& operator>>=(unsigned shift) {
+        const uint64_t extension = isNegative() ? UINT64_MAX : 0;
+        const size_t wordShift = shift / 64;
+        const unsigned bitShift = shift % 64;
+        for (size_t i = 0; i < WORDS; i++) {
+            const uint64_t word = i + wordShift < WORDS ? words[i + wordShift] : extension;
+            const uint64_t upper = i + wordShift + 1 < WORDS ? words[i + wordShift + 1] : extension;
+            words[i] = bitShift ? (word >> bitShift) | (upper << (64 - bitShift)) : word;
+        }
+        return *this;
+    }
+
+    friend constexpr FixedLongNum operator<<(FixedLongNum number, unsigned shift) {
+        return number <<= shift;
+    }
+    friend constexpr FixedLongNum operator>>(FixedLongNum number, unsigned shift) {
+        return number >>= shift;
+    }
+
+private:
+    std::array<uint64_t, WORDS> words{};
+
+    constexpr bool isNegative(void) const {
+        return words[WORDS - 1] >> 63;
+    }
+
+    // Sign-extends bit BITS - 1 into the unused bits of the top word
+    constexpr void normalize(void) {
+        if constexpr (BITS % 64 != 0) {
+            constexpr unsigned unused = 64 - BITS % 64;
+            words[WORDS - 1] = static_cast<uint64_t>(static_cast<int64_t>(words[WORDS - 1] << unused) >> unused);
+        }
+    }
+
+    constexpr void negate(void) {
+        uint64_t carry = 1;
+        for (uint64_t& word : words) {
+            word = ~word + carry;
+            carry = carry && word == 0;
+        }
+    }
+
+    // |value| * 2^FracBits, with the unused bits of the top word clear. The words are negated without
+    // normalize(), which would sign-extend the magnitude 2^(BITS - 1) of the minimum back to itself
+    constexpr std::array<uint64_t, WORDS> magnitude(void) const {
+        if (!isNegative()) {
+            return words;
+        }
+        FixedLongNum result = *this;
+        result.negate();
+        return result.words;
+    }
+
+    static constexpr uint64_t mulWide(uint64_t a, uint64_t b, uint64_t& high) {
+#if defined(__SIZEOF_INT128__) && (!defined(LONGNUM_WIDE_KERNELS) || LONGNUM_WIDE_KERNELS)
+        __extension__ typedef unsigned __int128 uint128_t;
+        const uint128_t product = static_cast<uint128_t>(a) * b;
+        high = static_cast<uint64_t>(product >> 64);
+        return static_cast<uint64_t>(product);
+#else
+        const uint64_t a0 = a & UINT32_MAX, a1 = a >> 32, b0 = b & UINT32_MAX, b1 = b >> 32;
+        const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+        const uint64_t middle = (p00 >> 32) + (p01 & UINT32_MAX) + (p10 & UINT32_MAX);
+        high = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+        return (middle << 32) | (p00 & UINT32_MAX);
+#endif
+    }
+
+    template <size_t N>
+    static constexpr void shiftLimbsLeft(std::array<uint32_t, N>& x, unsigned shift) {
+        const size_t limbShift = shift / 32;
+        const unsigned bitShift = shift % 32;
+        for (size_t i = N; i-- > 0;) {
+            const uint32_t limb = i >= limbShift ? x[i - limbShift] : 0;
+            const uint32_t lower = i >= limbShift + 1 ? x[i - limbShift - 1] : 0;
+            x[i] = bitShift ? (limb << bitShift) | (lower >> (32 - bitShift)) : limb;
+        }
+    }
+
+    // u[0..m) / v[0..n) with v[n-1] != 0 and m >= n, u has a spare limb on top.
+    // Knuth, TAOCP vol. 2, 4.3.1, Algorithm D
+    template <size_t M, size_t N>
+    static constexpr std::array<uint32_t, M> divideLimbs(std::array<uint32_t, M> u, size_t m,
+                                                         std::array<uint32_t, N> v, size_t n) {
+        std::array<uint32_t, M> q{};
+        if (n == 1) {
+            uint64_t rem = 0;
+            for (size_t i = m; i-- > 0;) {
+                const uint64_t cur = (rem << 32) | u[i];
+                q[i] = static_cast<uint32_t>(cur / v[0]);
+                rem = cur % v[0];
+            }
+            return q;
+        }
+        const unsigned s = std::countl_zero(v[n - 1]);
+        shiftLimbsLeft(u, s);
+        shiftLimbsLeft(v, s);
+        const uint64_t top = v[n - 1], next = v[n - 2];
+        for (size_t j = m - n + 1; j-- > 0;) {
+            const uint64_t num = (static_cast<uint64_t>(u[j + n]) << 32) | u[j + n - 1];
+            uint64_t qhat = num / top;
+            uint64_t rhat = num % top;
+            while (qhat >> 32 || qhat * next > ((rhat << 32) | u[j + n - 2])) {
+                qhat--;
+                rhat += top;
+                if (rhat >> 32) {
+                    break;
+                }
+            }
+            uint64_t borrow = 0;
+            for (size_t i = 0; i < n; i++) {
+                const uint64_t product = qhat * v[i] + borrow;
+                const uint32_t low = static_cast<uint32_t>(product);
+                borrow = (product >> 32) + (u[i + j] < low);
+                u[i + j] -= low;
+            }
+            const bool negative = u[j + n] < borrow;
+            u[j + n] -= static_cast<uint32_t>(borrow);
+            if (negative) {
+                qhat--;
+                uint64_t carry = 0;
+                for (size_t i = 0; i < n; i++) {
+                    const uint64_t sum = static_cast<uint64_t>(u[i + j]) + v[i] + carry;
+                    u[i + j] = static_cast<uint32_t>(sum);
+                    carry = sum >> 32;
+                }
+                u[j + n] += static_cast<uint32_t>(carry);
+            }
+            q[j] = static_cast<uint32_t>(qhat);
+        }
+        return q;
+    }
+};
+
+template <unsigned IntBits, unsigned FracBits>
+FixedLongNum<IntBits, FracBits>::FixedLongNum(const LongNum& number) {
+    // |number| * 2^FracBits from its limbs, which are scaled by B^F
+    const LimbVector& digits = number.digits;
+    const int64_t shift = static_cast<int64_t>(FracBits) - 32 * static_cast<int64_t>((number.precision + 31) / 32);
+    const size_t limbShift = shift >= 0 ? shift / 32 : -shift / 32;
+    const unsigned bitShift = shift >= 0 ? shift % 32 : -shift % 32;
+    std::vector<uint32_t> raw;
+    if (shift >= 0) {
+        raw.assign(limbShift, 0);
+        raw.insert(raw.end(), digits.begin(), digits.end());
+        raw.push_back(0);
+        for (size_t i = raw.size(); bitShift && i-- > limbShift;) {
+            raw[i] = (raw[i] << bitShift) | (i > limbShift ? raw[i - 1] >> (32 - bitShift) : 0);
+        }
+    } else if (limbShift < digits.size()) {
+        raw.assign(digits.begin() + limbShift, digits.end());
+        for (size_t i = 0; bitShift && i < raw.size(); i++) {
+            raw[i] = (raw[i] >> bitShift) | (i + 1 < raw.size() ? raw[i + 1] << (32 - bitShift) : 0);
+        }
+    }
+    bool fits = true;
+    for (size_t i = 0; i < raw.size(); i++) {
+        if (i < 2 * WORDS) {
+            words[i / 2] |= static_cast<uint64_t>(raw[i]) << (32 * (i % 2));
+        } else {
+            fits = fits && raw[i] == 0;
+        }
+    }
+    // The magnitude must be below 2^(BITS - 1), or equal to it for a negative number
+    constexpr size_t signWord = (BITS - 1) / 64;
+    constexpr unsigned signBit = (BITS - 1) % 64;
+    bool above = (words[signWord] >> signBit) >> 1;
+    bool below = words[signWord] & ((uint64_t(1) << signBit) - 1);
+    for (size_t i = 0; i < WORDS; i++) {
+        above = above || (i > signWord && words[i]);
+        below = below || (i < signWord && words[i]);
+    }
+    const bool minimum = number.isNegative && !below;
+    fits = fits && !above && (!((words[signWord] >> signBit) & 1) || minimum);
+    if (!fits) {
+        throw std::out_of_range("Number does not fit into " + std::to_string(IntBits) + " integer bits");
+    }
+    if (number.isNegative) {
+        negate();
+    }
+    normalize();
+}
+
+template <unsigned IntBits, unsigned FracBits>
+FixedLongNum<IntBits, FracBits>::operator LongNum() const {
+    // The magnitude shifted to whole fractional limbs
+    const std::array<uint64_t, WORDS> a = magnitude();
+    const uint32_t fractionDigits = (FracBits + 31) / 32;
+    const unsigned shift = 32 * fractionDigits - FracBits;
+    LongNum result = 0LL;
+    result.precision = FracBits;
+    result.isNegative = isNegative();
+    result.digits.assign(2 * WORDS + 1, 0);
+    for (size_t i = 0; i < 2 * WORDS; i++) {
+        const uint64_t limb = static_cast<uint32_t>(a[i / 2] >> (32 * (i % 2)));
+        result.digits[i] |= static_cast<uint32_t>(limb << shift);
+        result.digits[i + 1] |= static_cast<uint32_t>((limb << shift) >> 32);
+    }
+    while (result.digits.size() > fractionDigits && result.digits.back() == 0) {
+        result.digits.pop_back();
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,365 @@
+#ifndef LIMB_VECTOR_H
+#define LIMB_VECTOR_H
+#include "Allocator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+
+// Limb storage of LongNum: a vector of uint32_t that keeps up to INLINE_CAPACITY limbs inside
+// the object and only goes to the heap for longer numbers. Small integers such as loop counters
+// and constants therefore never allocate. Iterators are plain pointers, growth is geometric.
+// Heap buffers are aligned to a cache line and come from the memory resource current at
+// construction (see limbs::currentResource);
+// like std::pmr containers, moves between different resources copy the limbs.
+//
+// Heap buffers are reference counted and copied on write: copies within one memory resource share
+// the buffer, and the first non-const access to the limbs (or any change of them) gives the vector
+// a buffer of its own. Erasing limbs at the front only moves the start of the vector, so dropping
+// fractional limbs costs nothing, and inserting at the front reuses that space while the buffer is
+// not shared. A pointer from a non-const access is invalidated by copying the vector.
+//
+// A borrowed vector (see borrow()) reads limbs owned by someone else, such as a mapped file. It
+// behaves like a shared one, and copies of it get limbs of their own
+class LimbVector {
+public:
+    using value_type = uint32_t;
+    using iterator = uint32_t*;
+    using const_iterator = const uint32_t*;
+
+    static constexpr size_t INLINE_CAPACITY = 8;
+
+    LimbVector() noexcept = default;
+
+    LimbVector(const LimbVector& other) {
+        if (other.isLocal() || other.borrowed || other.resource != resource) {
+            assign(other.begin(), other.end());
+        } else {
+            share(other);
+        }
+    }
+
+    LimbVector(LimbVector&& other) noexcept {
+        take(other);
+    }
+
+    LimbVector& operator=(const LimbVector& other) {
+        if (this == &other) {
+            return *this;
+        }
+        if (other.isLocal() || other.borrowed || other.resource != resource) {
+            assign(other.begin(), other.end());
+        } else if (other.base != base) {
+            release();
+            share(other);
+        } else {
+            // Views of the same buffer
+            ptr = other.ptr;
+            count = other.count;
+            limit = other.limit;
+        }
+        return *this;
+    }
+
+    LimbVector& operator=(LimbVector&& other) {
+        if (this == &other) {
+            return *this;
+        }
+        if (other.isLocal() || other.resource == resource) {
+            release();
+            take(other);
+        } else {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    ~LimbVector() {
+        release();
+    }
+
+    size_t size(void) const {
+        return count;
+    }
+    size_t capacity(void) const {
+        return limit;
+    }
+    bool empty(void) const {
+        return count == 0;
+    }
+    // Whether another vector refers to the same heap buffer, or the limbs are borrowed
+    bool shared(void) const {
+        return base && (borrowed || references()->load(std::memory_order_acquire) > 1);
+    }
+
+    // A vector of n limbs at `limbs`, which must stay valid and unchanged while it or any vector
+    // moved from it refers to them. They are never written: changes go to a copy
+    static LimbVector borrow(const uint32_t* limbs, size_t n) {
+        LimbVector result;
+        if (n == 0) {
+            return result;
+        }
+        result.base = result.ptr = const_cast<uint32_t*>(limbs);
+        result.count = result.limit = n;
+        result.borrowed = true;
+        return result;
+    }
+
+    uint32_t* data(void) {
+        unshare();
+        return ptr;
+    }
+    const uint32_t* data(void) const {
+        return ptr;
+    }
+    uint32_t* begin(void) {
+        unshare();
+        return ptr;
+    }
+    const uint32_t* begin(void) const {
+        return ptr;
+    }
+    uint32_t* end(void) {
+        unshare();
+        return ptr + count;
+    }
+    const uint32_t* end(void) const {
+        return ptr + count;
+    }
+
+    uint32_t& operator[](size_t index) {
+        unshare();
+        return ptr[index];
+    }
+    const uint32_t& operator[](size_t index) const {
+        return ptr[index];
+    }
+    uint32_t& back(void) {
+        unshare();
+        return ptr[count - 1];
+    }
+    const uint32_t& back(void) const {
+        return ptr[count - 1];
+    }
+
+    void reserve(size_t n) {
+        if (n > limit) {
+            reallocate(n);
+        }
+    }
+
+    void resize(size_t n, uint32_t value = 0) {
+        if (n > count) {
+            grow(n);
+            std::fill(ptr + count, ptr + n, value);
+        }
+        count = n;
+    }
+
+    // Like resize, but new limbs are left uninitialized for the caller to overwrite
+    void resize_for_overwrite(size_t n) {
+        grow(n);
+        count = n;
+    }
+
+    void assign(size_t n, uint32_t value) {
+        count = 0;
+        resize(n, value);
+    }
+
+    // The range must not point into this vector
+    template <typename It>
+    void assign(It first, It last) {
+        const size_t n = std::distance(first, last);
+        count = 0;
+        grow(n);
+        std::copy(first, last, ptr);
+        count = n;
+    }
+
+    void push_back(uint32_t value) {
+        grow(count + 1);
+        ptr[count++] = value;
+    }
+
+    void pop_back(void) {
+        count--;
+    }
+
+    void clear(void) {
+        count = 0;
+    }
+
+    uint32_t* insert(const uint32_t* pos, size_t n, uint32_t value) {
+        const size_t index = pos - ptr;
+        if (index == 0) {
+            insert_front(n, value);
+            return ptr;
+        }
+        grow(count + n);
+        std::copy_backward(ptr + index, ptr + count, ptr + count + n);
+        std::fill(ptr + index, ptr + index + n, value);
+        count += n;
+        return ptr + index;
+    }
+
+    uint32_t* erase(const uint32_t* first, const uint32_t* last) {
+        const size_t index = first - ptr;
+        const size_t n = last - first;
+        if (index == 0) {
+            erase_front(n);
+            return ptr;
+        }
+        unshare();
+        std::copy(ptr + index + n, ptr + count, ptr + index);
+        count -= n;
+        return ptr + index;
+    }
+
+    // n limbs with the value before the first one. Reuses the space left by erase_front while the
+    // buffer is not shared. Unlike insert(begin(), ...), does not copy a shared buffer before the
+    // insertion
+    void insert_front(size_t n, uint32_t value) {
+        if (base && static_cast<size_t>(ptr - base) >= n && !shared()) {
+            ptr -= n;
+            limit += n;
+        } else {
+            grow(count + n);
+            std::copy_backward(ptr, ptr + count, ptr + count + n);
+        }
+        std::fill(ptr, ptr + n, value);
+        count += n;
+    }
+
+    // Drops the first n limbs. A heap buffer stays where it is, shared or not
+    void erase_front(size_t n) {
+        if (isLocal()) {
+            std::copy(ptr + n, ptr + count, ptr);
+        } else {
+            ptr += n;
+            limit -= n;
+        }
+        count -= n;
+    }
+
+    void swap(LimbVector& other) {
+        LimbVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+private:
+    using Counter = std::atomic<size_t>;
+
+    std::pmr::memory_resource* resource = limbs::currentResource;
+    // Start of the heap buffer, null for the inline limbs
+    uint32_t* base = nullptr;
+    uint32_t* ptr = local;
+    size_t count = 0;
+    // Limbs from ptr to the end of the buffer
+    size_t limit = INLINE_CAPACITY;
+    // The heap buffer belongs to someone else and has no reference count
+    bool borrowed = false;
+    uint32_t local[INLINE_CAPACITY];
+
+    bool isLocal(void) const {
+        return base == nullptr;
+    }
+
+    // The reference count follows the limbs of a heap buffer
+    static size_t countOffset(size_t limbs) {
+        return (limbs * sizeof(uint32_t) + alignof(Counter) - 1) / alignof(Counter) * alignof(Counter);
+    }
+    static size_t bufferBytes(size_t limbs) {
+        return countOffset(limbs) + sizeof(Counter);
+    }
+    size_t bufferLimbs(void) const {
+        return ptr + limit - base;
+    }
+    Counter* references(void) const {
+        return reinterpret_cast<Counter*>(reinterpret_cast<char*>(base) + countOffset(bufferLimbs()));
+    }
+
+    void grow(size_t n) {
+        if (n > limit) {
+            reallocate(std::max(n, 2 * limit));
+        } else if (shared()) {
+            reallocate(n);
+        }
+    }
+
+    // Gives the vector a buffer of its own before its limbs are changed
+    void unshare(void) {
+        if (shared()) {
+            reallocate(count);
+        }
+    }
+
+    // Moves the limbs (up to n of them) to a new buffer of its own for n limbs, or inline if they fit
+    void reallocate(size_t n) {
+        count = std::min(count, n);
+        if (n <= INLINE_CAPACITY) {
+            std::copy(ptr, ptr + count, local);
+            release(false);
+            return;
+        }
+        uint32_t* buffer = static_cast<uint32_t*>(limbs::allocate(resource, bufferBytes(n), limbs::CACHE_LINE));
+        ::new (reinterpret_cast<char*>(buffer) + countOffset(n)) Counter(1);
+        std::copy(ptr, ptr + count, buffer);
+        release(false);
+        base = ptr = buffer;
+        limit = n;
+    }
+
+    // Drops the reference to the heap buffer, `clear` also forgets the limbs
+    void release(bool clear = true) {
+        if (!isLocal() && !borrowed) {
+            Counter* counter = references();
+            if (counter->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                const size_t limbs = bufferLimbs();
+                counter->~Counter();
+                limbs::deallocate(resource, base, bufferBytes(limbs), limbs::CACHE_LINE);
+            }
+        }
+        base = nullptr;
+        ptr = local;
+        limit = INLINE_CAPACITY;
+        borrowed = false;
+        if (clear) {
+            count = 0;
+        }
+    }
+
+    // Refers to the heap buffer of other, from the same resource. *this must not own a heap buffer
+    void share(const LimbVector& other) {
+        other.references()->fetch_add(1, std::memory_order_relaxed);
+        base = other.base;
+        ptr = other.ptr;
+        count = other.count;
+        limit = other.limit;
+    }
+
+    // Takes the contents (and the resource of a heap buffer) of other and leaves it empty.
+    // *this must not own a heap buffer
+    void take(LimbVector& other) noexcept {
+        if (other.isLocal()) {
+            std::copy(other.local, other.local + other.count, local);
+        } else {
+            resource = other.resource;
+            base = other.base;
+            ptr = other.ptr;
+            limit = other.limit;
+            borrowed = other.borrowed;
+            other.base = nullptr;
+            other.borrowed = false;
+            other.ptr = other.local;
+            other.limit = INLINE_CAPACITY;
+        }
+        count = other.count;
+        other.count = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,392 @@
+#ifndef LIMBS_H
+#define LIMBS_H
+#include "Allocator.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 64-bit word kernels: pairs of limbs are processed as one word with 128-bit products and
+// add-with-carry. They need unsigned __int128 and a little-endian host, build with
+// -DLONGNUM_WIDE_KERNELS=0 to get the portable 32-bit loops
+#ifndef LONGNUM_WIDE_KERNELS
+#if defined(__SIZEOF_INT128__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LONGNUM_WIDE_KERNELS 1
+#else
+#define LONGNUM_WIDE_KERNELS 0
+#endif
+#endif
+
+#if LONGNUM_WIDE_KERNELS && defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+// Vector kernels for shifts and scans, picked at run time (Simd.cpp). x86-64 only, build with
+// -DLONGNUM_SIMD=0 to leave them out
+#ifndef LONGNUM_SIMD
+#ifdef __x86_64__
+#define LONGNUM_SIMD 1
+#else
+#define LONGNUM_SIMD 0
+#endif
+#endif
+
+// Internal kernels working on raw little-endian arrays of 32-bit limbs.
+// They know nothing about signs or precision, LongNum takes care of that.
+namespace limbs {
+
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+#if LONGNUM_WIDE_KERNELS
+    // Limbs p[0], p[1] as one word
+    inline uint64_t loadWord(const uint32_t* p) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    }
+
+    inline void storeWord(uint32_t* p, uint64_t word) {
+        std::memcpy(p, &word, sizeof(word));
+    }
+
+    // a + b + carry, carry is updated
+    inline uint64_t addCarry(uint64_t a, uint64_t b, unsigned char& carry) {
+#ifdef __x86_64__
+        unsigned long long sum;
+        carry = _addcarry_u64(carry, a, b, &sum);
+        return sum;
+#else
+        const uint128_t sum = static_cast<uint128_t>(a) + b + carry;
+        carry = static_cast<unsigned char>(sum >> 64);
+        return static_cast<uint64_t>(sum);
+#endif
+    }
+
+    // a - b - borrow, borrow is updated
+    inline uint64_t subBorrow(uint64_t a, uint64_t b, unsigned char& borrow) {
+#ifdef __x86_64__
+        unsigned long long diff;
+        borrow = _subborrow_u64(borrow, a, b, &diff);
+        return diff;
+#else
+        const uint128_t diff = static_cast<uint128_t>(a) - b - borrow;
+        borrow = static_cast<unsigned char>(diff >> 127);
+        return static_cast<uint64_t>(diff);
+#endif
+    }
+#endif
+
+#if LONGNUM_SIMD
+    namespace simd {
+
+        // Shorter operands stay with the inline loops below
+        constexpr size_t MIN_LIMBS = 16;
+
+        uint32_t lshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits);
+        uint32_t rshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits);
+        int cmp(const uint32_t* a, const uint32_t* b, size_t n);
+        size_t significantSize(const uint32_t* x, size_t n);
+
+        // Instruction set of the kernels in use: "avx512", "avx2", "sse2" or "scalar"
+        const char* name(void);
+
+    }
+#endif
+
+    // Primitives in the style of GMP's mpn layer: every operand is n limbs, there are no
+    // bounds checks, carries and borrows are returned to the caller. The loops over two operands
+    // do not branch on the limbs; add1 and sub1 stop propagating once the carry or borrow dies
+    // and cmp returns at the first differing limb. out may be the same array as an input operand
+
+    // out[0..n) = a[0..n) + b[0..n) + carry, returns the carry out of the top limb
+    inline uint32_t addN(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n, uint32_t carry = 0) {
+        size_t i = 0;
+#if LONGNUM_WIDE_KERNELS
+        unsigned char wideCarry = static_cast<unsigned char>(carry);
+        for (; i + 7 < n; i += 8) {
+            storeWord(out + i, addCarry(loadWord(a + i), loadWord(b + i), wideCarry));
+            storeWord(out + i + 2, addCarry(loadWord(a + i + 2), loadWord(b + i + 2), wideCarry));
+            storeWord(out + i + 4, addCarry(loadWord(a + i + 4), loadWord(b + i + 4), wideCarry));
+            storeWord(out + i + 6, addCarry(loadWord(a + i + 6), loadWord(b + i + 6), wideCarry));
+        }
+        for (; i + 1 < n; i += 2) {
+            storeWord(out + i, addCarry(loadWord(a + i), loadWord(b + i), wideCarry));
+        }
+        carry = wideCarry;
+#endif
+        for (; i < n; i++) {
+            const uint64_t sum = static_cast<uint64_t>(a[i]) + b[i] + carry;
+            out[i] = static_cast<uint32_t>(sum);
+            carry = static_cast<uint32_t>(sum >> 32);
+        }
+        return carry;
+    }
+
+    // out[0..n) = a[0..n) - b[0..n) - borrow, returns the borrow out of the top limb
+    inline uint32_t subN(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n, uint32_t borrow = 0) {
+        size_t i = 0;
+#if LONGNUM_WIDE_KERNELS
+        unsigned char wideBorrow = static_cast<unsigned char>(borrow);
+        for (; i + 7 < n; i += 8) {
+            storeWord(out + i, subBorrow(loadWord(a + i), loadWord(b + i), wideBorrow));
+            storeWord(out + i + 2, subBorrow(loadWord(a + i + 2), loadWord(b + i + 2), wideBorrow));
+            storeWord(out + i + 4, subBorrow(loadWord(a + i + 4), loadWord(b + i + 4), wideBorrow));
+            storeWord(out + i + 6, subBorrow(loadWord(a + i + 6), loadWord(b + i + 6), wideBorrow));
+        }
+        for (; i + 1 < n; i += 2) {
+            storeWord(out + i, subBorrow(loadWord(a + i), loadWord(b + i), wideBorrow));
+        }
+        borrow = wideBorrow;
+#endif
+        for (; i < n; i++) {
+            const uint64_t diff = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+            out[i] = static_cast<uint32_t>(diff);
+            borrow = static_cast<uint32_t>(diff >> 63);
+        }
+        return borrow;
+    }
+
+    // out[0..n) = a[0..n) + carry for a carry of 0 or 1, returns the carry out of the top limb
+    inline uint32_t add1(uint32_t* out, const uint32_t* a, size_t n, uint32_t carry) {
+        size_t i = 0;
+        for (; carry && i < n; i++) {
+            out[i] = a[i] + 1;
+            carry = out[i] == 0;
+        }
+        if (out != a) {
+            std::copy(a + i, a + n, out + i);
+        }
+        return carry;
+    }
+
+    // out[0..n) = a[0..n) - borrow for a borrow of 0 or 1, returns the borrow out of the top limb
+    inline uint32_t sub1(uint32_t* out, const uint32_t* a, size_t n, uint32_t borrow) {
+        size_t i = 0;
+        for (; borrow && i < n; i++) {
+            borrow = a[i] == 0;
+            out[i] = a[i] - 1;
+        }
+        if (out != a) {
+            std::copy(a + i, a + n, out + i);
+        }
+        return borrow;
+    }
+
+    // out[0..n) = a[0..n) * m, returns the high limb of the product
+    inline uint32_t mul1(uint32_t* out, const uint32_t* a, size_t n, uint32_t m) {
+        uint64_t carry = 0;
+        size_t i = 0;
+#if LONGNUM_WIDE_KERNELS
+        for (; i + 1 < n; i += 2) {
+            const uint128_t cur = static_cast<uint128_t>(loadWord(a + i)) * m + carry;
+            storeWord(out + i, static_cast<uint64_t>(cur));
+            carry = static_cast<uint64_t>(cur >> 64);
+        }
+#endif
+        for (; i < n; i++) {
+            const uint64_t cur = static_cast<uint64_t>(a[i]) * m + carry;
+            out[i] = static_cast<uint32_t>(cur);
+            carry = cur >> 32;
+        }
+        return static_cast<uint32_t>(carry);
+    }
+
+    // out[0..n) += a[0..n) * m, returns the limb carried out of the top
+    inline uint32_t addmul1(uint32_t* out, const uint32_t* a, size_t n, uint32_t m) {
+        uint64_t carry = 0;
+        size_t i = 0;
+#if LONGNUM_WIDE_KERNELS
+        for (; i + 1 < n; i += 2) {
+            const uint128_t cur = static_cast<uint128_t>(loadWord(a + i)) * m + loadWord(out + i) + carry;
+            storeWord(out + i, static_cast<uint64_t>(cur));
+            carry = static_cast<uint64_t>(cur >> 64);
+        }
+#endif
+        for (; i < n; i++) {
+            const uint64_t cur = static_cast<uint64_t>(a[i]) * m + out[i] + carry;
+            out[i] = static_cast<uint32_t>(cur);
+            carry = cur >> 32;
+        }
+        return static_cast<uint32_t>(carry);
+    }
+
+    // out[0..n) -= a[0..n) * m, returns the limb borrowed from above the top
+    inline uint32_t submul1(uint32_t* out, const uint32_t* a, size_t n, uint32_t m) {
+        uint64_t borrow = 0;
+        size_t i = 0;
+#if LONGNUM_WIDE_KERNELS
+        for (; i + 1 < n; i += 2) {
+            const uint128_t product = static_cast<uint128_t>(loadWord(a + i)) * m + borrow;
+            const uint64_t low = static_cast<uint64_t>(product);
+            const uint64_t word = loadWord(out + i);
+            storeWord(out + i, word - low);
+            borrow = static_cast<uint64_t>(product >> 64) + (word < low);
+        }
+#endif
+        for (; i < n; i++) {
+            const uint64_t product = static_cast<uint64_t>(a[i]) * m + borrow;
+            const uint32_t low = static_cast<uint32_t>(product);
+            borrow = (product >> 32) + (out[i] < low);
+            out[i] -= low;
+        }
+        return static_cast<uint32_t>(borrow);
+    }
+
+    // q[0..n) = a[0..n) / d, returns a % d. q may be a, or null when only the remainder is needed
+    inline uint32_t divRem1(uint32_t* q, const uint32_t* a, size_t n, uint32_t d) {
+        uint64_t rem = 0;
+        for (size_t i = n; i-- > 0;) {
+            const uint64_t cur = (rem << 32) | a[i];
+            if (q) {
+                q[i] = static_cast<uint32_t>(cur / d);
+            }
+            rem = cur % d;
+        }
+        return static_cast<uint32_t>(rem);
+    }
+
+    // out[0..n) = a[0..n) << bits for bits < 32, returns the bits shifted out of the top.
+    // out may also lie above a
+    inline uint32_t lshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+#if LONGNUM_SIMD
+        if (n >= simd::MIN_LIMBS) {
+            return simd::lshift(out, a, n, bits);
+        }
+#endif
+        if (n == 0) {
+            return 0;
+        }
+        const uint32_t high = static_cast<uint32_t>((static_cast<uint64_t>(a[n - 1]) << bits) >> 32);
+        for (size_t i = n - 1; i > 0; i--) {
+            out[i] = (a[i] << bits) | static_cast<uint32_t>((static_cast<uint64_t>(a[i - 1]) << bits) >> 32);
+        }
+        out[0] = a[0] << bits;
+        return high;
+    }
+
+    // out[0..n) = a[0..n) >> bits for bits < 32, returns the bits shifted out of the bottom
+    // in the high end of a limb. out may also lie below a
+    inline uint32_t rshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+#if LONGNUM_SIMD
+        if (n >= simd::MIN_LIMBS) {
+            return simd::rshift(out, a, n, bits);
+        }
+#endif
+        if (n == 0) {
+            return 0;
+        }
+        const uint32_t low = static_cast<uint32_t>(static_cast<uint64_t>(a[0]) << (32 - bits));
+        for (size_t i = 0; i + 1 < n; i++) {
+            out[i] = (a[i] >> bits) | static_cast<uint32_t>(static_cast<uint64_t>(a[i + 1]) << (32 - bits));
+        }
+        out[n - 1] = a[n - 1] >> bits;
+        return low;
+    }
+
+    // Sign of a[0..n) - b[0..n)
+    inline int cmp(const uint32_t* a, const uint32_t* b, size_t n) {
+#if LONGNUM_SIMD
+        if (n >= simd::MIN_LIMBS) {
+            return simd::cmp(a, b, n);
+        }
+#endif
+        for (size_t i = n; i-- > 0;) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // out[0..n) += x[0..nx), nx <= n. The sum must fit into n limbs
+    inline void addInto(uint32_t* out, size_t n, const uint32_t* x, size_t nx) {
+        add1(out + nx, out + nx, n - nx, addN(out, out, x, nx));
+    }
+
+    // out[0..n) -= x[0..nx), nx <= n. The difference must be non-negative
+    inline void subInto(uint32_t* out, size_t n, const uint32_t* x, size_t nx) {
+        sub1(out + nx, out + nx, n - nx, subN(out, out, x, nx));
+    }
+
+    // Length of x without its leading zero limbs
+    inline size_t significantSize(const uint32_t* x, size_t n) {
+#if LONGNUM_SIMD
+        if (n >= simd::MIN_LIMBS && x[n - 1] == 0) {
+            return simd::significantSize(x, n);
+        }
+#endif
+        while (n && x[n - 1] == 0) {
+            n--;
+        }
+        return n;
+    }
+
+    // out[0..na+nb) = a * b. out must not overlap the operands. Passing the same operand twice
+    // squares it as in sqr
+    void mul(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+    // out[0..2n) = a^2 with squaring kernels at every tier, which compute each cross product once
+    void sqr(uint32_t* out, const uint32_t* a, size_t n);
+
+    // out[skip..na+nb) = the limbs of a * b from `skip` on, exactly, while out[0..skip) is only
+    // scratch space. Mostly a short product with two guard limbs below `skip`, a full product
+    // when the guard limbs are too close to a carry for the error bound of the short one
+    void mulHigh(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t skip);
+
+    // q[0..na-nb] = a / b, r[0..nb) = a % b. Requires na >= nb and b[nb-1] != 0.
+    // Either output may be null if it is not needed
+    void divRem(uint32_t* q, uint32_t* r, const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+    // A divisor prepared for dividing many numbers by it. A single limb gets the Möller-Granlund
+    // inverse floor((B^2 - 1) / d) - B of its normalised value, so that every quotient limb takes
+    // two multiplications instead of a hardware division. Divisors long enough for Newton
+    // division keep their reciprocal, and dividends are processed in blocks of the divisor size
+    class Divisor {
+    public:
+        // b[nb-1] != 0
+        Divisor(const uint32_t* b, size_t nb);
+
+        // The same as limbs::divRem(q, r, a, na, b, nb)
+        void divRem(uint32_t* q, uint32_t* r, const uint32_t* a, size_t na) const;
+
+        const Buffer& value(void) const {
+            return divisor;
+        }
+        size_t size(void) const {
+            return divisor.size();
+        }
+
+    private:
+        Buffer divisor;
+        // The divisor shifted left until its top bit is set
+        unsigned shift;
+        Buffer normalized;
+        uint32_t inverse = 0;
+        // floor(B^2n / normalized), only for divisors that take Newton division
+        Buffer reciprocal;
+    };
+
+    // Decimal digits of x, left-padded with zeros to `width` characters
+    std::string toDecimal(const uint32_t* x, size_t n, size_t width = 0);
+
+    // The first `count` decimal places of f / B^n (truncated). If the expansion ends earlier,
+    // it is returned without trailing zeros
+    std::string fractionToDecimal(const uint32_t* f, size_t n, size_t count);
+
+    // Value of a string of decimal or hexadecimal digits (already validated), without leading zero limbs
+    Buffer fromDecimal(std::string_view digits);
+    Buffer fromHex(std::string_view digits);
+
+    // 0.digits * B^n: n fractional limbs followed by the carry into the integer part.
+    // Decimal fractions are rounded to the nearest, hexadecimal ones are truncated
+    Buffer fractionFromDecimal(std::string_view digits, size_t n);
+    Buffer fractionFromHex(std::string_view digits, size_t n);
+
+}
+
+#endif
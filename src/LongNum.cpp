@@ -1,513 +1,1019 @@
-
-#include "LongNum.hpp"
-#include <compare>
-#include <bitset>
-#include <cmath>
-#include <stdexcept>
-#include <limits>
-#include <iostream>
-
-constexpr unsigned BASE = 32;
-constexpr unsigned DEFAULT_PRECISION = 64;
-
-// ****** Constructors and destructors ******
-
-LongNum::LongNum(long long number) : precision(0), isNegative(number < 0){
-    if (number == 0) {
-        return;
-    }
-    number = std::abs(number);
-    while (number) {
-        digits.push_back(number & UINT32_MAX);
-        number >>= BASE;
-    }
-}
-
-LongNum::LongNum(unsigned long long number) : precision(0){
-    if (number == 0) {
-        return;
-    }
-    while (number) {
-        digits.push_back(number & UINT32_MAX);
-        number >>= BASE;
-    }
-}
-
-LongNum::LongNum(long double number) : LongNum(number, DEFAULT_PRECISION) {
-}
-
-LongNum::LongNum(long double number, uint32_t precision) : precision(precision), isNegative(number < 0){
-    number = number < 0 ? -number : number;
-    long double intPart;
-    long double fracPart = std::modf(number, &intPart);
-    initializeFraction();
-
-    const long double epsilon = std::numeric_limits<long double>::epsilon();
-    int i = 0;
-    uint32_t fractionDigits = getFractionDigits();
-    while (std::abs(fracPart) > epsilon && i < fractionDigits) {
-        fracPart *= (1ULL << BASE);
-        auto digit = static_cast<uint32_t>(std::trunc(fracPart));
-        digits[fractionDigits - i - 1] = digit;
-        fracPart -= digit;
-        i++;
-    }
-    while (intPart >= 1.0) {
-        digits.push_back(static_cast<uint32_t>(std::fmod(intPart, 1ULL << BASE)));
-        intPart /= (1ULL << BASE);
-    }
-}
-
-// Private methods
-
-
-void LongNum::initializeFraction(void) {
-    uint32_t fractionDigits = 0;
-    while (32 * fractionDigits < precision) {
-        digits.push_back(0);
-        fractionDigits++;
-    }
-}
-
-void LongNum::printDigits() {
-    for (size_t i = 0; i < digits.size(); i++) {
-        std::cout << digits[i] << " ";
-    }
-    std::cout << std::endl;
-}
-void LongNum::printBinaryDigits() {
-    for (int i = digits.size() - 1; i >= 0; i--) {
-        std::bitset<BASE> bits(digits[i]);  // 32 бита для uint32_t
-        std::string binary_string = bits.to_string();
-        std::cout << binary_string << " ";
-
-    }
-    std::cout << std::endl;
-}
-
-
-uint32_t LongNum::getFractionDigits() const {
-    return (precision/BASE) + (precision % BASE != 0);
-}
-
-void LongNum::removeLeadingZeros() {
-    while (digits.size() > getFractionDigits() && digits.back() == 0) {
-        digits.pop_back();
-    }
-}
-
-LongNum LongNum::abs(void) const {
-	LongNum result = *this;
-	result.isNegative = false;
-	return result;
-}
-
-LongNum LongNum::pow(uint32_t power) const {
-    LongNum res = 1, a = *this;
-    while (power) {
-        if (power & 1)
-            res *= a;
-        a *= a;
-        power >>= 1;
-    }
-    return res;
-}
-
-LongNum LongNum::sqrt() const {
-    if (*this < 0) {
-        throw std::invalid_argument("Number is negative");
-    }
-    LongNum num1 = 0, num2 = 1;
-    while (num1 != num2) {
-        num1 = num2;
-        num2 += *this / num2;
-        num2 >>= 1;
-    }
-    return num2;
-}
-
-std::string LongNum::toString(uint32_t decimalPrecision) const {
-    const LongNum base = 10;
-    std::string res;
-    LongNum intPart = (*this).withPrecision(0).abs();
-    while (intPart != 0) {
-        LongNum q = intPart / base;
-        LongNum r = intPart - (q * base);
-        if (r == 0) {
-            res += '0';
-        } else {
-            res += std::to_string(r.digits.front());
-        }
-        intPart = q;
-    }
-    if (res.empty()) {
-        res += '0';
-    }
-    if (isNegative) {
-        res += '-';
-    }
-    std::ranges::reverse(res);
-    if (decimalPrecision == 0) {
-        return res;
-    }
-    LongNum fracPart = ((*this) - (*this).withPrecision(0)).abs();
-    if (fracPart == 0) {
-        return res;
-    }
-    res += '.';
-    unsigned cnt = 0;
-    while (fracPart != 0 && cnt++ < decimalPrecision) {
-        fracPart *= base;
-        LongNum r = fracPart.withPrecision(0);
-        if (r == 0) {
-            res += '0';
-        } else {
-            res += std::to_string(r.digits.front());
-        }
-        fracPart -= r;
-    }
-    return res;
-}
-
-// Precision
-
-void LongNum::setPrecision(uint32_t newPrecision) {
-    uint32_t newFractionDigits = newPrecision/32 + (newPrecision % 32 != 0);
-    uint32_t fractionDigits = getFractionDigits();
-    precision = newPrecision;
-    if (newFractionDigits == fractionDigits) {
-        return;
-    }
-    int diff = newFractionDigits - fractionDigits;
-    
-    if (diff > 0) {
-        digits.insert(digits.begin(), diff,0);
-    }
-    else{
-        digits.erase(digits.begin(), digits.begin() - diff);
-    }
-}
-
-
-uint32_t LongNum::getPrecision() const {
-    return precision;
-}
-
-LongNum LongNum::withPrecision(uint32_t precision) const{
-    LongNum result(*this);
-    result.setPrecision(precision);
-    return result;
-}
-
-// Operators
-LongNum& LongNum::operator=(const LongNum& other) {
-    if (this != &other) {
-        digits = other.digits;
-        precision = other.precision;
-        isNegative = other.isNegative;
-    }
-    return *this;
-}
-
-LongNum & LongNum::operator<<=(uint32_t shift) {
-    *this = *this << shift;
-    return *this;
-}
-
-LongNum & LongNum::operator>>=(uint32_t shift) {
-    *this = *this >> shift;
-    return *this;
-}
-
-LongNum & LongNum::operator+=(const LongNum &other) {
-    *this = *this + other;
-    return *this;
-}
-
-LongNum & LongNum::operator-=(const LongNum &other) {
-    *this = *this - other;
-    return *this;
-}
-
-LongNum & LongNum::operator*=(const LongNum &other) {
-    *this = *this * other;
-    return *this;
-}
-
-LongNum & LongNum::operator/=(const LongNum &other) {
-    *this = *this / other;
-    return *this;
-}
-
-LongNum operator<<(const LongNum &number, unsigned shift) {
-    LongNum result(number);
-    uint32_t newDigits = shift / 32;
-    if (newDigits) {
-        result.digits.insert(result.digits.begin(), newDigits, 0);
-    }
-    shift = shift % 32;
-    if (shift) {
-        uint32_t carry = 0;
-        for (size_t i = newDigits; i < result.digits.size(); i++) {
-            uint32_t newCarry = result.digits[i] >> (32 - shift);
-            result.digits[i] <<= shift;
-            result.digits[i] |= carry;
-            carry = newCarry;
-        }
-        if (carry) {
-            result.digits.push_back(carry);
-        }
-    }
-    return result;
-
-}
-
-LongNum operator>>(const LongNum &number, unsigned shift) {
-    LongNum result(number);
-    uint32_t numDigits = shift / 32;
-    if (numDigits >= result.digits.size()) {
-        return (0.0_longnum).withPrecision(number.precision);
-    }
-    result.digits.erase(result.digits.begin(), result.digits.begin() + numDigits);
-    shift = shift % 32;
-    if (shift) {
-        uint32_t carry = 0;
-        for (int i = result.digits.size() - 1; i >= 0; i--) {
-            uint32_t newCarry =  result.digits[i] << (32 - shift);
-            result.digits[i] >>= shift;
-            result.digits[i] |= carry;
-            carry = newCarry;
-        }
-    }
-    result.removeLeadingZeros();
-    return result;
-}
-
-LongNum LongNum::operator+() const {
-    return *this;
-}
-
-LongNum LongNum::operator-() const {
-    LongNum res(*this);
-    if (*this != 0) {  // -0 == +0
-        res.isNegative ^= 1;
-    }
-    return res;
-}
-
-LongNum operator+(const LongNum& lnum,const LongNum& rnum) {
-    if (lnum.isNegative != rnum.isNegative) {
-        return lnum.isNegative ? rnum - (-lnum) : lnum - (-rnum);
-    }
-    uint32_t maxPrecision = std::max(lnum.precision, rnum.precision);
-    int l_fractionDigits = lnum.getFractionDigits();
-    int r_fractionDigits = rnum.getFractionDigits();
-    LongNum result(0.0,maxPrecision);
-    int maxFractionDigits = std::max(l_fractionDigits, r_fractionDigits);
-    int maxSize = std::max(lnum.digits.size() - l_fractionDigits, rnum.digits.size() - r_fractionDigits) + maxFractionDigits;
-    while (result.digits.size() < maxSize) {
-        result.digits.push_back(0);
-    }
-    uint32_t carry = 0;
-    for (int i = 0; i < maxSize; i++) {
-        uint64_t sum = carry;
-        int index1 = i - (maxFractionDigits - l_fractionDigits);
-        if (index1 >= 0 && index1 < lnum.digits.size())
-            sum += lnum.digits[index1];
-
-        int index2 = i - (maxFractionDigits - r_fractionDigits);
-        if (index2 >= 0 && index2 < rnum.digits.size())
-            sum += rnum.digits[index2];
-        carry = sum >> BASE;
-        result.digits[i] = static_cast<uint32_t>(sum);
-    }
-    if (carry != 0) {
-        result.digits.push_back(carry);
-    }
-
-    result.isNegative = lnum.isNegative;
-    result.precision = maxPrecision;
-    return result;
-}
-
-LongNum operator-(const LongNum &lnum,const LongNum &rnum) {
-    if (lnum.isNegative || rnum.isNegative) {
-        if (lnum.isNegative == rnum.isNegative) return (-rnum) - (-lnum);
-        return (-rnum) + lnum;
-    }
-    uint32_t maxPrecision = std::max(lnum.precision, rnum.precision);
-    LongNum result(0L,maxPrecision);
-    int l_fractionDigits = lnum.getFractionDigits();
-    int r_fractionDigits = rnum.getFractionDigits();
-    int maxFractionDigits = std::max(l_fractionDigits, r_fractionDigits);
-    int maxSize = std::max(lnum.digits.size() - l_fractionDigits, rnum.digits.size() - r_fractionDigits) + maxFractionDigits;
-    while (result.digits.size() < maxSize) {
-        result.digits.push_back(0);
-    }
-    std::strong_ordering ordering = lnum.absCompare(rnum);
-    if (ordering == std::strong_ordering::equal) {
-        result.removeLeadingZeros();
-        return result;
-    }
-    bool  isBorrow = false;
-    for (int i = 0; i < maxSize; i++) {
-        int index1 = i - (maxFractionDigits - l_fractionDigits);
-        int index2 = i - (maxFractionDigits - r_fractionDigits);
-        uint64_t greaterDigit = 0;
-        uint64_t lowerDigit = 0;
-        if (ordering == std::strong_ordering::greater) {
-            if (index1 >= 0 && index1 < lnum.digits.size()) greaterDigit += lnum.digits[index1];
-            if (index2 >= 0 && index2 < rnum.digits.size()) lowerDigit += rnum.digits[index2];
-        }
-        else {
-            if (index1 >= 0 && index1 < lnum.digits.size()) lowerDigit += lnum.digits[index1];
-            if (index2 >= 0 && index2 < rnum.digits.size()) greaterDigit += rnum.digits[index2];
-        }
-        if (greaterDigit == 0 && isBorrow) {
-            greaterDigit += (1ULL << 32) - 1;
-            }
-        else if (isBorrow) {
-            greaterDigit--;
-            isBorrow = false;
-        }
-
-        if (greaterDigit < lowerDigit) {
-            isBorrow = true;
-            greaterDigit += (1ULL << 32) - lowerDigit;
-        }
-        else {
-            greaterDigit -= lowerDigit;
-        }
-        result.digits[i] = greaterDigit;
-    }
-    result.removeLeadingZeros();
-    result.isNegative = ordering == std::strong_ordering::greater ? false : true;
-    return result;
-}
-
-LongNum operator*(const LongNum& lnum,const LongNum& rnum) {
-    if (lnum == 0 || rnum == 0) {
-        LongNum result(0.0,std::max(lnum.precision, rnum.precision));
-        return result;
-    }
-
-    LongNum result(0.0,static_cast<uint32_t>(lnum.precision + rnum.precision));
-    result.digits.resize(lnum.digits.size() + rnum.digits.size());
-    for (size_t i = 0; i < lnum.digits.size(); i++) {
-        uint32_t carry = 0;
-        for (size_t j = 0; j < rnum.digits.size() || carry; j++) {
-            if (j < rnum.digits.size()) {
-                const uint64_t cur = static_cast<uint64_t>(lnum.digits[i]) * rnum.digits[j] + result.digits[i + j] + carry;
-                result.digits[i + j] = cur;
-                carry = cur >> 32;
-            } else {
-                result.digits[i + j] += carry;
-                carry = 0;
-            }
-        }
-    }
-    result.removeLeadingZeros();
-    result.setPrecision(std::max(lnum.precision, rnum.precision));
-    result.isNegative = lnum.isNegative ^ rnum.isNegative;
-    return result;
-}
-
-LongNum operator/(const LongNum& lnum,const LongNum& rnum) {
-    if (rnum == 0) {
-        throw std::invalid_argument("Division by zero");
-    }
-    if (lnum == 0) {
-        return (0_longnum).withPrecision(std::max(lnum.precision, rnum.precision));
-    }
-    uint32_t maxPrecision = std::max(lnum.precision, rnum.precision);
-	uint32_t normPrecision = std::max(maxPrecision, 96U);
-
-	LongNum l_copy = lnum.abs().withPrecision(normPrecision);
-
-	LongNum r_copy = rnum.abs().withPrecision(normPrecision);
-
-	l_copy <<= l_copy.getFractionDigits() * 32;
-
-	LongNum result(0.0L, normPrecision);
-	result.isNegative = lnum.isNegative ^ rnum.isNegative;
-	LongNum rem(0.0L, normPrecision);
-
-	
-	for (int i = l_copy.digits.size() * 32 - 1; i >= 0; --i) {
-		rem <<= 1;
-        uint32_t digitIndex = i / 32;
-	    uint32_t bitIndex = i % 32;
-	    bool bit = (l_copy.digits[digitIndex] >> bitIndex) & 1;
-		rem.digits[0] |= (bit ? 1 : 0);
-		if (rem >= r_copy) {
-			rem -= r_copy;
-	        if (digitIndex >= result.digits.size()) {
-		        result.digits.resize(digitIndex + 1, 0);
-            }
-	        result.digits[digitIndex] |= (1U << bitIndex);
-	    }
-		}
-        result.setPrecision(maxPrecision);
-	    result.removeLeadingZeros();  
-	    return result;
-}
-
-bool LongNum::operator==(const LongNum &other) const{
-    return (*this <=> other) == std::strong_ordering::equal;
-}
-
-bool LongNum::operator!=(const LongNum &other) const {
-    return (*this <=> other) != std::strong_ordering::equal;
-}
-
-bool LongNum::operator<(const LongNum &other) const {
-    return (*this <=> other) == std::strong_ordering::less;
-}
-
-bool LongNum::operator>(const LongNum &other) const {
-    return (*this <=> other) == std::strong_ordering::greater;
-}
-
-std::strong_ordering LongNum::absCompare(const LongNum &other) const {
-    if (digits.size() - getFractionDigits() != other.digits.size() - other.getFractionDigits()) {
-        return digits.size() - getFractionDigits() < other.digits.size() - other.getFractionDigits() ?
-            std::strong_ordering::less : std::strong_ordering::greater;
-    }
-    int maxSize = std::max(digits.size(), other.digits.size());
-    for (int i = maxSize - 1; i >= 0; i--) {
-        if (i < maxSize - digits.size()) {
-            if (other.digits[i] != 0) return std::strong_ordering::less;
-            continue;
-        }
-        if (i < maxSize - other.digits.size()) {
-            if (digits[i] != 0) return std::strong_ordering::greater;
-            continue;
-        }
-        uint32_t ldigit = digits[i - (maxSize - digits.size())];
-        uint32_t rdigit = other.digits[i - (maxSize - other.digits.size())];
-        if (ldigit != rdigit) {
-            return ldigit >  rdigit ? std::strong_ordering::greater : std::strong_ordering::less;
-        }
-    }
-    return std::strong_ordering::equal;
-}
-
-
-std::strong_ordering LongNum::operator<=>(const LongNum &other) const {
-    if (isNegative != other.isNegative) {
-        return isNegative ? std::strong_ordering::less : std::strong_ordering::greater;
-    }
-    return absCompare(other);
-}
-
-LongNum operator""_longnum(const long double number) {
-    return LongNum(number, 64);
-}
-
-LongNum operator""_longnum(const unsigned long long number) {
-    return LongNum(number);
-}
-
-
-
-
+
+#include "LongNum.hpp"
+#include "Limbs.hpp"
+#include "Parallel.hpp"
+#include "Swap.hpp"
+#include <compare>
+#include <bit>
+#include <bitset>
+#include <cmath>
+#include <stdexcept>
+#include <limits>
+#include <iostream>
+#include <cctype>
+#include <string>
+
+constexpr unsigned BASE = 32;
+constexpr unsigned DEFAULT_PRECISION = 64;
+
+static LongNum::Thresholds thresholds;
+
+// ****** Constructors and destructors ******
+
+LongNum::LongNum(long long number) : precision(0), isNegative(number < 0){
+    if (number == 0) {
+        return;
+    }
+    number = std::abs(number);
+    while (number) {
+        digits.push_back(number & UINT32_MAX);
+        number >>= BASE;
+    }
+}
+
+LongNum::LongNum(unsigned long long number) : precision(0){
+    if (number == 0) {
+        return;
+    }
+    while (number) {
+        digits.push_back(number & UINT32_MAX);
+        number >>= BASE;
+    }
+}
+
+LongNum::LongNum(long double number) : LongNum(number, DEFAULT_PRECISION) {
+}
+
+LongNum::LongNum(long double number, uint32_t precision) : precision(precision), isNegative(number < 0){
+    number = number < 0 ? -number : number;
+    long double intPart;
+    long double fracPart = std::modf(number, &intPart);
+    initializeFraction();
+
+    const long double epsilon = std::numeric_limits<long double>::epsilon();
+    int i = 0;
+    uint32_t fractionDigits = getFractionDigits();
+    while (std::abs(fracPart) > epsilon && i < fractionDigits) {
+        fracPart *= (1ULL << BASE);
+        auto digit = static_cast<uint32_t>(std::trunc(fracPart));
+        digits[fractionDigits - i - 1] = digit;
+        fracPart -= digit;
+        i++;
+    }
+    while (intPart >= 1.0) {
+        digits.push_back(static_cast<uint32_t>(std::fmod(intPart, 1ULL << BASE)));
+        intPart /= (1ULL << BASE);
+    }
+}
+
+LongNum::LongNum(std::string_view number, uint32_t precision) : precision(precision) {
+    stats::Scope scope(stats::Operation::Parse, number.size() / 8);
+    std::string_view rest = number;
+    bool negative = false;
+    if (!rest.empty() && (rest.front() == '-' || rest.front() == '+')) {
+        negative = rest.front() == '-';
+        rest.remove_prefix(1);
+    }
+    const bool hex = rest.starts_with("0x") || rest.starts_with("0X");
+    if (hex) {
+        rest.remove_prefix(2);
+    }
+    const size_t point = rest.find('.');
+    const std::string_view intPart = rest.substr(0, point);
+    const std::string_view fracPart = point == std::string_view::npos ? std::string_view() : rest.substr(point + 1);
+    auto isDigit = [hex](char c) {
+        return hex ? std::isxdigit(static_cast<unsigned char>(c)) : std::isdigit(static_cast<unsigned char>(c));
+    };
+    if ((intPart.empty() && fracPart.empty()) || !std::ranges::all_of(intPart, isDigit) ||
+        !std::ranges::all_of(fracPart, isDigit)) {
+        throw std::invalid_argument("Wrong number format: " + std::string(number));
+    }
+
+    const uint32_t fractionDigits = getFractionDigits();
+    const limbs::Buffer fraction = hex ? limbs::fractionFromHex(fracPart, fractionDigits)
+                                               : limbs::fractionFromDecimal(fracPart, fractionDigits);
+    digits.assign(fraction.begin(), fraction.end());
+    const limbs::Buffer intDigits = hex ? limbs::fromHex(intPart) : limbs::fromDecimal(intPart);
+    digits.resize(fractionDigits + intDigits.size() + 1, 0);
+    limbs::addInto(digits.data() + fractionDigits, intDigits.size() + 1, intDigits.data(), intDigits.size());
+    removeLeadingZeros();
+    isNegative = negative && limbs::significantSize(digits.data(), digits.size()) != 0;
+}
+
+LongNum::LongNum(const LongNum& other, size_t capacity) : isNegative(other.isNegative), precision(other.precision) {
+    // A copy of the limbs, not a shared buffer: the room reserved is for the result computed in place
+    digits.reserve(std::max(capacity, other.digits.size()));
+    digits.assign(other.digits.begin(), other.digits.end());
+}
+
+LongNum LongNum::fromHex(std::string_view number, uint32_t precision) {
+    std::string prefixed(number);
+    const size_t start = !prefixed.empty() && (prefixed.front() == '-' || prefixed.front() == '+');
+    prefixed.insert(start, "0x");
+    return LongNum(prefixed, precision);
+}
+
+// Private methods
+
+
+void LongNum::initializeFraction(void) {
+    uint32_t fractionDigits = 0;
+    while (32 * fractionDigits < precision) {
+        digits.push_back(0);
+        fractionDigits++;
+    }
+}
+
+void LongNum::printDigits() {
+    for (size_t i = 0; i < digits.size(); i++) {
+        std::cout << digits[i] << " ";
+    }
+    std::cout << std::endl;
+}
+void LongNum::printBinaryDigits() {
+    for (int i = digits.size() - 1; i >= 0; i--) {
+        std::bitset<BASE> bits(digits[i]);  // 32 бита для uint32_t
+        std::string binary_string = bits.to_string();
+        std::cout << binary_string << " ";
+
+    }
+    std::cout << std::endl;
+}
+
+
+uint32_t LongNum::getFractionDigits() const {
+    return (precision/BASE) + (precision % BASE != 0);
+}
+
+void LongNum::removeLeadingZeros() {
+    while (digits.size() > getFractionDigits() && digits.back() == 0) {
+        digits.pop_back();
+    }
+}
+
+// Limbs of a sum or difference with other, including a carry
+size_t LongNum::sumDigits(const LongNum& other) const {
+    const uint32_t fractionDigits = getFractionDigits();
+    const uint32_t otherFractionDigits = other.getFractionDigits();
+    return std::max(digits.size() - fractionDigits, other.digits.size() - otherFractionDigits) +
+           std::max(fractionDigits, otherFractionDigits) + 1;
+}
+
+void LongNum::addAbs(const LongNum& other) {
+    const uint32_t fractionDigits = getFractionDigits();
+    const uint32_t otherFractionDigits = other.getFractionDigits();
+    // Read before resizing, other may be *this
+    const size_t otherSize = other.digits.size();
+    if (otherFractionDigits > fractionDigits) {
+        digits.insert_front(otherFractionDigits - fractionDigits, 0);
+    }
+    precision = std::max(precision, other.precision);
+    const size_t offset = getFractionDigits() - otherFractionDigits;
+    const size_t size = std::max(digits.size(), offset + otherSize) + 1;
+    digits.resize(size, 0);
+    swap::addInto(digits.data() + offset, size - offset, other.digits.data(), otherSize);
+    removeLeadingZeros();
+}
+
+void LongNum::subAbs(const LongNum& other, bool negate) {
+    const std::strong_ordering ordering = absCompare(other);
+    const uint32_t fractionDigits = getFractionDigits();
+    const uint32_t otherFractionDigits = other.getFractionDigits();
+    precision = std::max(precision, other.precision);
+    if (ordering == std::strong_ordering::equal) {
+        digits.assign(getFractionDigits(), 0);
+        isNegative = false;
+        return;
+    }
+    if (otherFractionDigits > fractionDigits) {
+        digits.insert_front(otherFractionDigits - fractionDigits, 0);
+    }
+    const size_t offset = getFractionDigits() - otherFractionDigits;
+    const size_t size = std::max(digits.size(), offset + other.digits.size());
+    digits.resize(size, 0);
+    if (ordering == std::strong_ordering::greater) {
+        swap::subInto(digits.data() + offset, size - offset, other.digits.data(), other.digits.size());
+    } else {
+        // this = other - this, the limbs of other start at offset
+        uint32_t* const x = digits.data();
+        const uint32_t zero = 0;
+        uint32_t borrow = 0;
+        for (size_t i = 0; i < offset; i++) {
+            borrow = limbs::subN(x + i, &zero, x + i, 1, borrow);
+        }
+        borrow = swap::subN(x + offset, other.digits.data(), x + offset, other.digits.size(), borrow);
+        for (size_t i = offset + other.digits.size(); i < size; i++) {
+            borrow = limbs::subN(x + i, &zero, x + i, 1, borrow);
+        }
+    }
+    removeLeadingZeros();
+    isNegative = (ordering == std::strong_ordering::less) != negate;
+}
+
+void LongNum::addAligned(LongNum& out, const LongNum& lnum, const LongNum& rnum, bool addMagnitudes) {
+    out.precision = std::max(lnum.precision, rnum.precision);
+    out.isNegative = lnum.isNegative;
+    if (addMagnitudes) {
+        const bool leftLonger = lnum.digits.size() >= rnum.digits.size();
+        const LimbVector& a = leftLonger ? lnum.digits : rnum.digits;
+        const LimbVector& b = leftLonger ? rnum.digits : lnum.digits;
+        out.digits.resize_for_overwrite(a.size() + 1);
+        const uint32_t carry = swap::addN(out.digits.data(), a.data(), b.data(), b.size());
+        out.digits[a.size()] = swap::add1(out.digits.data() + b.size(), a.data() + b.size(), a.size() - b.size(), carry);
+    } else {
+        const std::strong_ordering ordering = lnum.absCompare(rnum);
+        if (ordering == std::strong_ordering::equal) {
+            out.digits.assign(out.getFractionDigits(), 0);
+            out.isNegative = false;
+            return;
+        }
+        // The greater magnitude never has fewer limbs
+        const LimbVector& a = ordering == std::strong_ordering::greater ? lnum.digits : rnum.digits;
+        const LimbVector& b = ordering == std::strong_ordering::greater ? rnum.digits : lnum.digits;
+        out.digits.resize_for_overwrite(a.size());
+        const uint32_t borrow = swap::subN(out.digits.data(), a.data(), b.data(), b.size());
+        swap::sub1(out.digits.data() + b.size(), a.data() + b.size(), a.size() - b.size(), borrow);
+        out.isNegative = (ordering == std::strong_ordering::less) != lnum.isNegative;
+    }
+    out.removeLeadingZeros();
+}
+
+void LongNum::addSmall(uint64_t magnitude, bool negative) {
+    stats::Scope scope(stats::Operation::Add, digits.size() + 2);
+    const uint32_t fractionDigits = getFractionDigits();
+    const uint32_t other[2] = {static_cast<uint32_t>(magnitude), static_cast<uint32_t>(magnitude >> 32)};
+    const size_t otherSize = other[1] ? 2 : other[0] ? 1 : 0;
+    if (isNegative == negative) {
+        digits.resize(std::max(digits.size(), fractionDigits + otherSize) + 1, 0);
+        limbs::addInto(digits.data() + fractionDigits, digits.size() - fractionDigits, other, otherSize);
+        removeLeadingZeros();
+        return;
+    }
+    const std::strong_ordering ordering = absCompareSmall(magnitude);
+    if (ordering == std::strong_ordering::equal) {
+        digits.assign(fractionDigits, 0);
+        isNegative = false;
+        return;
+    }
+    if (ordering == std::strong_ordering::greater) {
+        limbs::subInto(digits.data() + fractionDigits, digits.size() - fractionDigits, other, otherSize);
+    } else {
+        // this = other - this, where the integer part of this has at most two limbs
+        digits.resize(fractionDigits + 2, 0);
+        uint32_t* const x = digits.data();
+        const uint32_t zero = 0;
+        uint32_t borrow = 0;
+        for (size_t i = 0; i < fractionDigits; i++) {
+            borrow = limbs::subN(x + i, &zero, x + i, 1, borrow);
+        }
+        limbs::subN(x + fractionDigits, other, x + fractionDigits, 2, borrow);
+        isNegative = negative;
+    }
+    removeLeadingZeros();
+}
+
+void LongNum::mulSmall(uint64_t magnitude, bool negative) {
+    stats::Scope scope(stats::Operation::Multiply, digits.size() + 2);
+    if (*this == 0 || magnitude == 0) {
+        digits.assign(getFractionDigits(), 0);
+        isNegative = false;
+        return;
+    }
+    const size_t n = digits.size();
+    if (magnitude <= UINT32_MAX) {
+        const uint32_t carry = limbs::mul1(digits.data(), digits.data(), n, static_cast<uint32_t>(magnitude));
+        if (carry) {
+            digits.push_back(carry);
+        }
+    } else {
+        limbs::Buffer product(n + 2);
+        product[n] = limbs::mul1(product.data(), digits.data(), n, static_cast<uint32_t>(magnitude));
+        product[n + 1] = limbs::addmul1(product.data() + 1, digits.data(), n, static_cast<uint32_t>(magnitude >> 32));
+        digits.assign(product.begin(), product.end());
+    }
+    removeLeadingZeros();
+    isNegative ^= negative;
+}
+
+void LongNum::addMulSmall(const LongNum& x, uint32_t m, bool negative) {
+    stats::Scope scope(stats::Operation::Multiply, digits.size() + x.digits.size() + 1);
+    const bool productNegative = x.isNegative != negative;
+    if (isZero()) {
+        isNegative = productNegative;
+    }
+    const uint32_t fractionDigits = getFractionDigits();
+    const uint32_t xFractionDigits = x.getFractionDigits();
+    if (xFractionDigits > fractionDigits) {
+        digits.insert_front(xFractionDigits - fractionDigits, 0);
+    }
+    precision = std::max(precision, x.precision);
+    const size_t offset = getFractionDigits() - xFractionDigits;
+    const size_t n = x.digits.size();
+    const size_t size = std::max(digits.size(), offset + n) + 1;
+    digits.resize(size, 0);
+    // The limb above the product absorbs its top limb, the rest only a carry or borrow bit
+    uint32_t* const out = digits.data() + offset;
+    const size_t rest = size - offset - n - 1;
+    if (isNegative == productNegative) {
+        const uint32_t carry = limbs::addmul1(out, x.digits.data(), n, m);
+        limbs::add1(out + n + 1, out + n + 1, rest, limbs::addN(out + n, out + n, &carry, 1));
+    } else {
+        const uint32_t borrow = limbs::submul1(out, x.digits.data(), n, m);
+        if (limbs::sub1(out + n + 1, out + n + 1, rest, limbs::subN(out + n, out + n, &borrow, 1))) {
+            // The product was the greater magnitude, the limbs hold its difference in two's complement
+            for (uint32_t& limb : digits) {
+                limb = ~limb;
+            }
+            limbs::add1(digits.data(), digits.data(), size, 1);
+            isNegative = productNegative;
+        }
+    }
+    removeLeadingZeros();
+    isNegative = isNegative && !isZero();
+}
+
+void LongNum::divSmall(uint64_t magnitude, bool negative) {
+    stats::Scope scope(stats::Operation::Divide, digits.size() + 2);
+    if (magnitude == 0) {
+        throw std::invalid_argument("Division by zero");
+    }
+    const uint32_t fractionDigits = getFractionDigits();
+    if (*this == 0) {
+        digits.assign(fractionDigits, 0);
+        return;
+    }
+    // The quotient keeps the fractional limbs of this: floor(|this| * B^F / |n|)
+    isNegative ^= negative;
+    const size_t n = digits.size();
+    if (magnitude <= UINT32_MAX) {
+        limbs::divRem1(digits.data(), digits.data(), n, static_cast<uint32_t>(magnitude));
+    } else if (n >= 2) {
+        const uint32_t divisor[2] = {static_cast<uint32_t>(magnitude), static_cast<uint32_t>(magnitude >> 32)};
+        limbs::Buffer quotient(n - 1);
+        limbs::divRem(quotient.data(), nullptr, digits.data(), n, divisor, 2);
+        digits.assign(quotient.begin(), quotient.end());
+    } else {
+        digits.clear();
+    }
+    digits.resize(std::max<size_t>(digits.size(), fractionDigits), 0);
+    removeLeadingZeros();
+}
+
+void LongNum::modSmall(uint64_t magnitude) {
+    stats::Scope scope(stats::Operation::Divide, digits.size() + 2);
+    if (magnitude == 0) {
+        throw std::invalid_argument("Division by zero");
+    }
+    const uint32_t fractionDigits = getFractionDigits();
+    uint32_t* const intPart = digits.data() + fractionDigits;
+    const size_t intDigits = digits.size() - fractionDigits;
+    if (magnitude <= UINT32_MAX) {
+        const uint32_t rem = limbs::divRem1(nullptr, intPart, intDigits, static_cast<uint32_t>(magnitude));
+        digits.resize(fractionDigits);
+        digits.push_back(rem);
+    } else if (absCompareSmall(magnitude) != std::strong_ordering::less) {
+        const uint32_t divisor[2] = {static_cast<uint32_t>(magnitude), static_cast<uint32_t>(magnitude >> 32)};
+        uint32_t rem[2];
+        limbs::divRem(nullptr, rem, intPart, intDigits, divisor, 2);
+        digits.resize(fractionDigits);
+        digits.push_back(rem[0]);
+        digits.push_back(rem[1]);
+    }
+    removeLeadingZeros();
+    isNegative = isNegative && !isZero();
+}
+
+std::strong_ordering LongNum::absCompareSmall(uint64_t magnitude) const {
+    const uint32_t fractionDigits = getFractionDigits();
+    const size_t intDigits = digits.size() - fractionDigits;
+    if (intDigits > 2) {
+        return std::strong_ordering::greater;
+    }
+    uint64_t value = intDigits > 0 ? digits[fractionDigits] : 0;
+    if (intDigits == 2) {
+        value |= static_cast<uint64_t>(digits[fractionDigits + 1]) << 32;
+    }
+    if (value != magnitude) {
+        return value < magnitude ? std::strong_ordering::less : std::strong_ordering::greater;
+    }
+    return limbs::significantSize(digits.data(), fractionDigits) != 0 ? std::strong_ordering::greater
+                                                                       : std::strong_ordering::equal;
+}
+
+std::strong_ordering LongNum::compareSmall(uint64_t magnitude, bool negative) const {
+    if (isNegative != negative) {
+        return isNegative ? std::strong_ordering::less : std::strong_ordering::greater;
+    }
+    const std::strong_ordering ordering = absCompareSmall(magnitude);
+    return isNegative ? 0 <=> ordering : ordering;
+}
+
+void LongNum::multiply(LongNum& out, const LongNum& lnum, const LongNum& rnum, uint32_t precision) {
+    stats::Scope scope(stats::Operation::Multiply, lnum.digits.size() + rnum.digits.size());
+    out.precision = precision;
+    out.isNegative = false;
+    if (lnum == 0 || rnum == 0) {
+        out.digits.assign(out.getFractionDigits(), 0);
+        return;
+    }
+    // The raw product has the fractional limbs of both operands, the extra ones are not computed
+    const size_t fractionDigits = lnum.getFractionDigits() + rnum.getFractionDigits();
+    const size_t extra = fractionDigits - std::min<size_t>(fractionDigits, out.getFractionDigits());
+    out.digits.resize_for_overwrite(lnum.digits.size() + rnum.digits.size());
+    limbs::mulHigh(out.digits.data(), lnum.digits.data(), lnum.digits.size(), rnum.digits.data(), rnum.digits.size(), extra);
+    out.digits.erase_front(extra);
+    if (out.getFractionDigits() > fractionDigits) {
+        out.digits.insert_front(out.getFractionDigits() - fractionDigits, 0);
+    }
+    out.removeLeadingZeros();
+    out.isNegative = lnum.isNegative ^ rnum.isNegative;
+}
+
+LongNum LongNum::mulTruncated(const LongNum& lnum, const LongNum& rnum, uint32_t precision) {
+    LongNum result = 0LL;
+    multiply(result, lnum, rnum, precision);
+    return result;
+}
+
+LongNum LongNum::abs(void) const & {
+	LongNum result = *this;
+	result.isNegative = false;
+	return result;
+}
+
+LongNum LongNum::abs(void) && {
+    isNegative = false;
+    return std::move(*this);
+}
+
+LongNum LongNum::square(void) const {
+    LongNum result = 0LL;
+    multiply(result, *this, *this, precision);
+    return result;
+}
+
+LongNum LongNum::pow(uint32_t power) const {
+    stats::Scope scope(stats::Operation::Pow, digits.size());
+    if (power == 0) {
+        return 1LL;
+    }
+    // Left-to-right sliding window: the odd powers below 2^window are precomputed, then every
+    // bit of the exponent costs a square and every window of bits a single product
+    const int bits = std::bit_width(power);
+    const int window = bits > 24 ? 4 : bits > 8 ? 3 : bits > 2 ? 2 : 1;
+    std::vector<LongNum> oddPowers = {*this};
+    if (window > 1) {
+        const LongNum squared = square();
+        for (int i = 1; i < (1 << (window - 1)); i++) {
+            oddPowers.push_back(oddPowers.back() * squared);
+        }
+    }
+
+    // Products go to a scratch number whose buffer is swapped back and forth
+    LongNum res = 0LL, product = 0LL;
+    bool started = false;
+    for (int i = bits - 1; i >= 0;) {
+        if (!((power >> i) & 1)) {
+            multiply(product, res, res, res.precision);
+            std::swap(res, product);
+            i--;
+            continue;
+        }
+        int low = std::max(i - window + 1, 0);
+        while (!((power >> low) & 1)) {
+            low++;
+        }
+        const uint32_t digit = (power >> low) & ((1u << (i - low + 1)) - 1);
+        if (started) {
+            for (int j = low; j <= i; j++) {
+                multiply(product, res, res, res.precision);
+                std::swap(res, product);
+            }
+            multiply(product, res, oddPowers[digit >> 1], std::max(res.precision, precision));
+            std::swap(res, product);
+        } else {
+            res = oddPowers[digit >> 1];
+            started = true;
+        }
+        i = low - 1;
+    }
+    return res;
+}
+
+LongNum LongNum::sqrt() const {
+    if (sign() < 0) {
+        throw std::invalid_argument("Number is negative");
+    }
+    // sqrt(x) * B^F = sqrt(x * B^2F): the integer root of the limbs with F more zero limbs below
+    // has the fractional limbs of the result
+    const uint32_t fractionDigits = getFractionDigits();
+    LongNum scaled = 0LL;
+    scaled.digits.resize(fractionDigits + digits.size(), 0);
+    std::copy(digits.begin(), digits.end(), scaled.digits.begin() + fractionDigits);
+    scaled.removeLeadingZeros();
+    LongNum result = scaled.isqrt();
+    result.precision = precision;
+    result.digits.resize(std::max<size_t>(result.digits.size(), fractionDigits), 0);
+    return result;
+}
+
+LongNum LongNum::isqrt(void) const {
+    return sqrtRem().first;
+}
+
+std::pair<LongNum, LongNum> LongNum::sqrtRem(void) const {
+    stats::Scope scope(stats::Operation::Sqrt, digits.size());
+    if (sign() < 0) {
+        throw std::invalid_argument("Number is negative");
+    }
+    const uint32_t fractionDigits = getFractionDigits();
+    LongNum n = 0LL;
+    n.digits.assign(digits.begin() + fractionDigits, digits.end());
+    if (n.isZero()) {
+        return {0LL, 0LL};
+    }
+
+    // y ~ 1 / sqrt(x) for x = n / 2^2k in [1/4, 1) by Newton's iteration y += y (1 - x y^2) / 2,
+    // which needs no division. It starts from a long double estimate and doubles the working
+    // precision every step, so the whole root costs a few full-size multiplications
+    const uint32_t bits = 32 * n.digits.size() - std::countl_zero(n.digits.back());
+    const uint32_t k = (bits + 1) / 2;
+    const uint32_t targetPrecision = k + 64;
+    const LongNum x = n.withPrecision(targetPrecision) >> (2 * k);
+    long double top = 0;
+    for (size_t i = n.digits.size(); i-- > 0 && i + 3 >= n.digits.size();) {
+        top += std::ldexp(static_cast<long double>(n.digits[i]), static_cast<int>(32 * i) - static_cast<int>(2 * k));
+    }
+    uint32_t current = 64;
+    LongNum y(1 / std::sqrt(top), current);
+    while (current < targetPrecision) {
+        current = std::min(2 * current, targetPrecision);
+        y.setPrecision(current);
+        const LongNum error = 1 - x.withPrecision(current) * y.square();
+        y += (y * error) >> 1;
+    }
+
+    // floor(n y / 2^k) is within a few units of the root, the remainder settles it
+    LongNum root = (n * y >> k).withPrecision(0);
+    LongNum remainder = n - root.square();
+    while (remainder < 0) {
+        root -= 1;
+        remainder += root * 2 + 1;
+    }
+    while (remainder > root * 2) {
+        remainder -= root * 2 + 1;
+        root += 1;
+    }
+    return {root, remainder};
+}
+
+std::string LongNum::toString(uint32_t decimalPrecision) const {
+    stats::Scope scope(stats::Operation::ToString, digits.size());
+    const uint32_t fractionDigits = getFractionDigits();
+    std::string res = limbs::toDecimal(digits.data() + fractionDigits, digits.size() - fractionDigits);
+    if (isNegative) {
+        res.insert(res.begin(), '-');
+    }
+    if (decimalPrecision == 0 || limbs::significantSize(digits.data(), fractionDigits) == 0) {
+        return res;
+    }
+    res += '.';
+    res += limbs::fractionToDecimal(digits.data(), fractionDigits, decimalPrecision);
+    return res;
+}
+
+// Precision
+
+void LongNum::setPrecision(uint32_t newPrecision) {
+    uint32_t newFractionDigits = newPrecision/32 + (newPrecision % 32 != 0);
+    uint32_t fractionDigits = getFractionDigits();
+    precision = newPrecision;
+    if (newFractionDigits == fractionDigits) {
+        return;
+    }
+    int diff = newFractionDigits - fractionDigits;
+    
+    if (diff > 0) {
+        digits.insert_front(diff, 0);
+    }
+    else{
+        digits.erase_front(-diff);
+    }
+}
+
+
+uint32_t LongNum::getPrecision() const {
+    return precision;
+}
+
+LongNum LongNum::withPrecision(uint32_t precision) const & {
+    LongNum result(*this);
+    result.setPrecision(precision);
+    return result;
+}
+
+LongNum LongNum::withPrecision(uint32_t precision) && {
+    setPrecision(precision);
+    return std::move(*this);
+}
+
+// Algorithm thresholds
+
+const LongNum::Thresholds& LongNum::getThresholds(void) {
+    return thresholds;
+}
+
+void LongNum::setThresholds(const Thresholds& newThresholds) {
+    if (newThresholds.karatsuba < 4 || newThresholds.toom3 < newThresholds.karatsuba ||
+        newThresholds.toom4 < newThresholds.toom3 || newThresholds.ntt < newThresholds.karatsuba) {
+        throw std::invalid_argument("Thresholds must satisfy 4 <= karatsuba <= toom3 <= toom4 and karatsuba <= ntt");
+    }
+    if (newThresholds.newtonDivision < 4) {
+        throw std::invalid_argument("Newton division threshold must be at least 4");
+    }
+    thresholds = newThresholds;
+}
+
+unsigned LongNum::getThreads(void) {
+    return parallel::threads();
+}
+
+void LongNum::setThreads(unsigned threads) {
+    parallel::setThreads(threads);
+}
+
+// Instrumentation
+
+LongNum::Stats LongNum::stats(void) {
+    return stats::snapshot();
+}
+
+void LongNum::resetStats(void) {
+    stats::reset();
+}
+
+// Operators
+LongNum& LongNum::operator=(const LongNum& other) {
+    if (this != &other) {
+        digits = other.digits;
+        precision = other.precision;
+        isNegative = other.isNegative;
+    }
+    return *this;
+}
+
+LongNum & LongNum::operator<<=(uint32_t shift) {
+    stats::Scope scope(stats::Operation::Shift, digits.size());
+    uint32_t newDigits = shift / 32;
+    if (newDigits) {
+        digits.insert_front(newDigits, 0);
+    }
+    shift = shift % 32;
+    if (shift) {
+        const uint32_t carry = swap::lshift(digits.data() + newDigits, digits.data() + newDigits,
+                                            digits.size() - newDigits, shift);
+        if (carry) {
+            digits.push_back(carry);
+        }
+    }
+    return *this;
+}
+
+LongNum & LongNum::operator>>=(uint32_t shift) {
+    stats::Scope scope(stats::Operation::Shift, digits.size());
+    uint32_t numDigits = shift / 32;
+    if (numDigits >= digits.size()) {
+        digits.assign(getFractionDigits(), 0);
+        isNegative = false;
+        return *this;
+    }
+    digits.erase_front(numDigits);
+    shift = shift % 32;
+    if (shift) {
+        swap::rshift(digits.data(), digits.data(), digits.size(), shift);
+    }
+    // Keep at least the fractional limbs when shifting a small number
+    if (digits.size() < getFractionDigits()) {
+        digits.resize(getFractionDigits(), 0);
+    }
+    removeLeadingZeros();
+    return *this;
+}
+
+LongNum & LongNum::operator+=(const LongNum &other) {
+    stats::Scope scope(stats::Operation::Add, digits.size() + other.digits.size());
+    if (isNegative == other.isNegative) {
+        addAbs(other);
+    } else {
+        subAbs(other, isNegative);
+    }
+    return *this;
+}
+
+LongNum & LongNum::operator-=(const LongNum &other) {
+    stats::Scope scope(stats::Operation::Subtract, digits.size() + other.digits.size());
+    if (isNegative == other.isNegative) {
+        subAbs(other, isNegative);
+    } else if (isNegative && other == 0) {
+        // -0 - 0 is +0
+        subAbs(other, true);
+    } else {
+        addAbs(other);
+    }
+    return *this;
+}
+
+LongNum & LongNum::operator*=(const LongNum &other) {
+    LongNum product = 0LL;
+    multiply(product, *this, other, std::max(precision, other.precision));
+    *this = std::move(product);
+    return *this;
+}
+
+LongNum & LongNum::operator/=(const LongNum &other) {
+    *this = *this / other;
+    return *this;
+}
+
+LongNum operator<<(const LongNum &number, unsigned shift) {
+    LongNum result(number, number.digits.size() + shift / 32 + 1);
+    result <<= shift;
+    return result;
+}
+
+LongNum operator<<(LongNum&& number, unsigned shift) {
+    number <<= shift;
+    return std::move(number);
+}
+
+LongNum operator>>(const LongNum &number, unsigned shift) {
+    LongNum result(number);
+    result >>= shift;
+    return result;
+}
+
+LongNum operator>>(LongNum&& number, unsigned shift) {
+    number >>= shift;
+    return std::move(number);
+}
+
+LongNum LongNum::operator+() const {
+    return *this;
+}
+
+LongNum LongNum::operator-() const & {
+    return -LongNum(*this);
+}
+
+LongNum LongNum::operator-() && {
+    if (*this != 0) {  // -0 == +0
+        isNegative ^= 1;
+    }
+    return std::move(*this);
+}
+
+LongNum operator+(const LongNum& lnum,const LongNum& rnum) {
+    if (lnum.getFractionDigits() == rnum.getFractionDigits()) {
+        stats::Scope scope(stats::Operation::Add, lnum.digits.size() + rnum.digits.size());
+        LongNum result = 0LL;
+        LongNum::addAligned(result, lnum, rnum, lnum.isNegative == rnum.isNegative);
+        return result;
+    }
+    LongNum result(lnum, lnum.sumDigits(rnum));
+    result += rnum;
+    return result;
+}
+
+LongNum operator+(LongNum&& lnum, const LongNum& rnum) {
+    lnum += rnum;
+    return std::move(lnum);
+}
+
+LongNum operator+(const LongNum& lnum, LongNum&& rnum) {
+    rnum += lnum;
+    return std::move(rnum);
+}
+
+LongNum operator+(LongNum&& lnum, LongNum&& rnum) {
+    lnum += rnum;
+    return std::move(lnum);
+}
+
+LongNum operator-(const LongNum &lnum,const LongNum &rnum) {
+    if (lnum.getFractionDigits() == rnum.getFractionDigits()) {
+        stats::Scope scope(stats::Operation::Subtract, lnum.digits.size() + rnum.digits.size());
+        // Same choice as operator-=, where -0 - 0 is +0
+        LongNum result = 0LL;
+        LongNum::addAligned(result, lnum, rnum, lnum.isNegative != rnum.isNegative && !(lnum.isNegative && rnum == 0));
+        return result;
+    }
+    LongNum result(lnum, lnum.sumDigits(rnum));
+    result -= rnum;
+    return result;
+}
+
+LongNum operator-(LongNum&& lnum, const LongNum& rnum) {
+    lnum -= rnum;
+    return std::move(lnum);
+}
+
+LongNum operator-(const LongNum& lnum, LongNum&& rnum) {
+    // lnum - rnum = -(rnum - lnum), neither of them is ever -0
+    rnum -= lnum;
+    return -std::move(rnum);
+}
+
+LongNum operator-(LongNum&& lnum, LongNum&& rnum) {
+    lnum -= rnum;
+    return std::move(lnum);
+}
+
+LongNum operator*(const LongNum& lnum,const LongNum& rnum) {
+    LongNum result = 0LL;
+    LongNum::multiply(result, lnum, rnum, std::max(lnum.precision, rnum.precision));
+    return result;
+}
+
+LongNum operator/(const LongNum& lnum,const LongNum& rnum) {
+    stats::Scope scope(stats::Operation::Divide, lnum.digits.size() + rnum.digits.size());
+    if (limbs::significantSize(rnum.digits.data(), rnum.digits.size()) == 0) {
+        throw std::invalid_argument("Division by zero");
+    }
+    uint32_t maxPrecision = std::max(lnum.precision, rnum.precision);
+    if (lnum == 0) {
+        return (0_longnum).withPrecision(maxPrecision);
+    }
+    uint32_t normPrecision = std::max(maxPrecision, 96U);
+
+    LongNum result(0.0L, normPrecision);
+    result.isNegative = lnum.isNegative ^ rnum.isNegative;
+
+    // With F fractional limbs at normPrecision, the quotient limbs are floor(|l| * B^(2F) / (|r| * B^F)).
+    // Only the difference of the scales is materialised, low zero limbs shared by both operands do not
+    // change the quotient
+    const uint32_t fractionDigits = result.getFractionDigits();
+    limbs::Buffer scaled(fractionDigits - lnum.getFractionDigits() + rnum.getFractionDigits(), 0);
+    scaled.insert(scaled.end(), lnum.digits.begin(), lnum.digits.end());
+    const uint32_t* a = scaled.data();
+    const uint32_t* b = rnum.digits.data();
+    size_t na = limbs::significantSize(a, scaled.size());
+    size_t nb = limbs::significantSize(b, rnum.digits.size());
+    while (na && *a == 0 && *b == 0) {
+        a++, na--;
+        b++, nb--;
+    }
+    if (na >= nb) {
+        result.digits.resize(std::max(result.digits.size(), na - nb + 1), 0);
+        limbs::divRem(result.digits.data(), nullptr, a, na, b, nb);
+    }
+    result.setPrecision(maxPrecision);
+    result.removeLeadingZeros();
+    return result;
+}
+
+// Divisor
+
+LongNum::Divisor::Divisor(const LongNum& value) : divisor(value), zeroLimbs(0) {
+    const uint32_t* b = divisor.digits.data();
+    size_t nb = limbs::significantSize(b, divisor.digits.size());
+    if (nb == 0) {
+        throw std::invalid_argument("Division by zero");
+    }
+    while (*b == 0) {
+        b++, nb--;
+        zeroLimbs++;
+    }
+    prepared = std::make_shared<const limbs::Divisor>(b, nb);
+}
+
+void LongNum::Divisor::quotientInto(LimbVector& out, const LongNum& number, ptrdiff_t offset) const {
+    stats::Scope scope(stats::Operation::Divide, number.digits.size() + divisor.digits.size());
+    // floor(floor(x / B^z) / y) = floor(x / (y * B^z)), so the zero limbs of the divisor are
+    // cut off the dividend, along with the limbs a negative offset drops
+    offset -= static_cast<ptrdiff_t>(zeroLimbs);
+    limbs::Buffer scaled;
+    const uint32_t* a = number.digits.data();
+    size_t na = number.digits.size();
+    if (offset > 0) {
+        scaled.assign(offset, 0);
+        scaled.insert(scaled.end(), number.digits.begin(), number.digits.end());
+        a = scaled.data();
+        na = scaled.size();
+    } else {
+        const size_t skip = std::min<size_t>(-offset, na);
+        a += skip;
+        na -= skip;
+    }
+    na = limbs::significantSize(a, na);
+    const size_t nb = prepared->size();
+    if (na >= nb) {
+        out.resize(std::max(out.size(), na - nb + 1), 0);
+        prepared->divRem(out.data(), nullptr, a, na);
+    }
+}
+
+LongNum LongNum::Divisor::divide(const LongNum& number) const {
+    const uint32_t maxPrecision = std::max(number.precision, divisor.precision);
+    if (number == 0) {
+        return (0_longnum).withPrecision(maxPrecision);
+    }
+    LongNum result(0.0L, std::max(maxPrecision, 96U));
+    result.isNegative = number.isNegative ^ divisor.isNegative;
+    const uint32_t fractionDigits = result.getFractionDigits();
+    quotientInto(result.digits, number,
+                 static_cast<ptrdiff_t>(fractionDigits + divisor.getFractionDigits()) - number.getFractionDigits());
+    result.setPrecision(maxPrecision);
+    result.removeLeadingZeros();
+    return result;
+}
+
+LongNum LongNum::Divisor::quotient(const LongNum& number) const {
+    LongNum result(0LL);
+    quotientInto(result.digits, number,
+                 static_cast<ptrdiff_t>(divisor.getFractionDigits()) - number.getFractionDigits());
+    result.removeLeadingZeros();
+    result.isNegative = (number.isNegative ^ divisor.isNegative) && !result.isZero();
+    return result;
+}
+
+LongNum LongNum::Divisor::remainder(const LongNum& number) const {
+    return divmod(number).second;
+}
+
+std::pair<LongNum, LongNum> LongNum::Divisor::divmod(const LongNum& number) const {
+    LongNum q = quotient(number);
+    LongNum r = number - q * divisor;
+    return {std::move(q), std::move(r)};
+}
+
+bool LongNum::operator==(const LongNum &other) const{
+    return (*this <=> other) == std::strong_ordering::equal;
+}
+
+bool LongNum::operator!=(const LongNum &other) const {
+    return (*this <=> other) != std::strong_ordering::equal;
+}
+
+bool LongNum::operator<(const LongNum &other) const {
+    return (*this <=> other) == std::strong_ordering::less;
+}
+
+bool LongNum::operator>(const LongNum &other) const {
+    return (*this <=> other) == std::strong_ordering::greater;
+}
+
+std::strong_ordering LongNum::absCompare(const LongNum &other) const {
+    const size_t fractionDigits = getFractionDigits();
+    const size_t otherFractionDigits = other.getFractionDigits();
+    const size_t intDigits = digits.size() - fractionDigits;
+    const size_t otherIntDigits = other.digits.size() - otherFractionDigits;
+    if (intDigits != otherIntDigits) {
+        return intDigits < otherIntDigits ? std::strong_ordering::less : std::strong_ordering::greater;
+    }
+    // Compare the limbs both numbers have, then the extra fractional limbs of the longer one
+    const size_t common = intDigits + std::min(fractionDigits, otherFractionDigits);
+    const int order = limbs::cmp(digits.data() + digits.size() - common,
+                                 other.digits.data() + other.digits.size() - common, common);
+    if (order != 0) {
+        return order < 0 ? std::strong_ordering::less : std::strong_ordering::greater;
+    }
+    if (limbs::significantSize(digits.data(), digits.size() - common) != 0) {
+        return std::strong_ordering::greater;
+    }
+    if (limbs::significantSize(other.digits.data(), other.digits.size() - common) != 0) {
+        return std::strong_ordering::less;
+    }
+    return std::strong_ordering::equal;
+}
+
+
+std::strong_ordering LongNum::operator<=>(const LongNum &other) const {
+    stats::Scope scope(stats::Operation::Compare, digits.size() + other.digits.size());
+    if (isNegative != other.isNegative) {
+        return isNegative ? std::strong_ordering::less : std::strong_ordering::greater;
+    }
+    return isNegative ? other.absCompare(*this) : absCompare(other);
+}
+
+bool LongNum::isZero(void) const {
+    return limbs::significantSize(digits.data(), digits.size()) == 0;
+}
+
+int LongNum::sign(void) const {
+    if (isZero()) {
+        return 0;
+    }
+    return isNegative ? -1 : 1;
+}
+
+LongNum operator""_longnum(const long double number) {
+    return LongNum(number, 64);
+}
+
+LongNum operator""_longnum(const unsigned long long number) {
+    return LongNum(number);
+}
+
+
+
+
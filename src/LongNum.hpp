@@ -1,77 +1,359 @@
-#ifndef LONGNUM_H
-#define LONGNUM_H
-#include <compare>
-#include <vector>
-#include <iostream>
-#include <algorithm>
-#include <cstdint>
-
-
-class LongNum {
-private:
-    std::vector<uint32_t> digits;
-    bool isNegative = false;
-    int precision;
-
-
-    void initializeFraction(void);
-    inline uint32_t getFractionDigits(void) const;
-    inline void removeLeadingZeros(void);
-
-public:
-    LongNum(long long number);
-    explicit LongNum(long double number);
-    explicit LongNum(unsigned long long x);
-    LongNum(long double number, uint32_t precision);
-    LongNum(const LongNum& other) = default;
-    ~LongNum() = default;
-
-
-    LongNum& operator=(const LongNum& other);
-
-    LongNum& operator<<=(uint32_t shift);
-    friend LongNum operator<<(const LongNum& number, unsigned shift);
-
-    LongNum& operator>>=(uint32_t shift);
-    friend LongNum operator>>(const LongNum& number, unsigned shift);
-
-    LongNum operator+() const;
-    LongNum operator-() const;
-
-    LongNum& operator+=(const LongNum& other);
-    LongNum& operator-=(const LongNum& other);
-    LongNum& operator*=(const LongNum& other);
-    LongNum& operator/=(const LongNum& other);
-
-    friend LongNum operator+(const LongNum& lnum,const LongNum& rnum);
-    friend LongNum operator-(const LongNum& lnum,const LongNum& rnum);
-    friend LongNum operator*(const LongNum& lnum,const LongNum& rnum);
-    friend LongNum operator/(const LongNum& lnum,const LongNum& rnum) ;
-
-
-    std::strong_ordering operator<=>(const LongNum &other) const;
-    std::strong_ordering absCompare(const LongNum &other) const;
-
-    bool operator==(const LongNum &other) const;
-    bool operator!=(const LongNum& other) const;
-    bool operator<(const LongNum& other) const;
-    bool operator>(const LongNum& other) const;
-
-
-     // Методы для работы с точностью
-    void setPrecision(uint32_t precision);
-    uint32_t getPrecision() const;
-    LongNum withPrecision(uint32_t precision) const;
-
-    std::string toString(unsigned decimalPrecision = UINT32_MAX) const;
-    LongNum abs(void) const;
-    LongNum pow(uint32_t power) const;
-    LongNum sqrt(void) const;
-
-    void printDigits(void);
-    void printBinaryDigits(void);
-
- };
- LongNum operator""_longnum(long double number);
- LongNum operator""_longnum(unsigned long long number);
-#endif
+#ifndef LONGNUM_H
+#define LONGNUM_H
+#include <compare>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <memory_resource>
+#include <concepts>
+#include <utility>
+#include "LimbVector.hpp"
+
+class LongNum;
+
+template <unsigned IntBits, unsigned FracBits>
+class FixedLongNum;
+
+class LongNumView;
+
+namespace limbs {
+    class Divisor;
+}
+
+// Evaluation of the expression templates in Expression.hpp
+namespace expr {
+    struct Term;
+    class Evaluator;
+    LongNum evaluate(const Term* terms, size_t count);
+    void accumulate(LongNum& out, const Term* terms, size_t count);
+}
+
+// Native integer operands of the mixed arithmetic and comparisons (bool is not a number here)
+template <typename T>
+concept NativeInteger = std::integral<T> && !std::same_as<std::remove_cv_t<T>, bool>;
+
+class LongNum {
+private:
+    LimbVector digits;
+    bool isNegative = false;
+    int precision;
+
+
+    void initializeFraction(void);
+    inline uint32_t getFractionDigits(void) const;
+    inline void removeLeadingZeros(void);
+    LongNum(const LongNum& other, size_t capacity);
+    size_t sumDigits(const LongNum& other) const;
+
+    // |this| += |other|, the sign is kept
+    void addAbs(const LongNum& other);
+    // this = |this| - |other| (negated if `negate` is set), zero is never negative
+    void subAbs(const LongNum& other, bool negate);
+    // out = lnum + rnum or lnum - rnum for operands with the same fractional limbs, whose limbs
+    // line up: `addMagnitudes` selects |lnum| + |rnum| with the sign of lnum, otherwise the
+    // magnitudes are subtracted as in subAbs(rnum, lnum.isNegative)
+    static void addAligned(LongNum& out, const LongNum& lnum, const LongNum& rnum, bool addMagnitudes);
+    // out = lnum * rnum truncated to `precision`, reusing the buffer of out, which must not be one
+    // of the operands
+    static void multiply(LongNum& out, const LongNum& lnum, const LongNum& rnum, uint32_t precision);
+
+    // Single-limb paths for native integer operands, given by their magnitude and sign. They
+    // give the same results as converting the integer to a LongNum first
+    void addSmall(uint64_t magnitude, bool negative);
+    void mulSmall(uint64_t magnitude, bool negative);
+    void divSmall(uint64_t magnitude, bool negative);
+    void modSmall(uint64_t magnitude);
+    std::strong_ordering absCompareSmall(uint64_t magnitude) const;
+    std::strong_ordering compareSmall(uint64_t magnitude, bool negative) const;
+
+    // this += x * m, or this -= x * m if `negative` is set, adding the product of every limb
+    // of x directly to the limbs of this. x must not be this
+    void addMulSmall(const LongNum& x, uint32_t m, bool negative);
+    friend class expr::Evaluator;
+    template <unsigned IntBits, unsigned FracBits>
+    friend class FixedLongNum;
+    friend class LongNumView;
+
+    template <NativeInteger T>
+    static uint64_t magnitudeOf(T value) {
+        return std::cmp_less(value, 0) ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    }
+
+public:
+    // Operand sizes (in 32-bit limbs of the shorter operand) at which multiplication
+    // switches from schoolbook to Karatsuba, Toom-3, Toom-4 and NTT, and the divisor and
+    // quotient size from which division uses a Newton reciprocal instead of long division
+    struct Thresholds {
+        size_t karatsuba = 32;
+        size_t toom3 = 300;
+        size_t toom4 = 1200;
+        size_t ntt = 4000;
+        size_t newtonDivision = 1000;
+    };
+
+    // Routes the limb buffers of numbers and kernel temporaries created on this thread (and in
+    // the parallel tasks it starts) to an arena until the end of the scope, which frees them at
+    // once. Bump only reuses the most recently freed block before that, Pool recycles freed
+    // blocks by size class. Numbers created inside the scope must not outlive it: assign the
+    // results to numbers created outside, which copies them out of the arena
+    class ScopedArena {
+    public:
+        enum class Kind { Bump, Pool };
+
+        explicit ScopedArena(Kind kind = Kind::Pool);
+        ScopedArena(const ScopedArena&) = delete;
+        ScopedArena& operator=(const ScopedArena&) = delete;
+        ~ScopedArena();
+
+    private:
+        std::unique_ptr<std::pmr::memory_resource> resource;
+        std::pmr::memory_resource* previous;
+    };
+
+    // Keeps the limb buffers of at least `threshold` bytes created on this thread (and in the
+    // parallel tasks it starts) in files in `directory` until the end of the scope, so numbers can
+    // outgrow the physical memory: the kernel writes their pages back to the files and reads them
+    // again as they are used. Disk space is reserved when a buffer is created, a full disk throws
+    // std::bad_alloc. Meanwhile additions, subtractions and shifts go over long numbers in blocks
+    // of threshold / 4 bytes (up to 32 MiB), reading the next block ahead, and operands of a
+    // product longer than a block are multiplied block by block in memory, which takes about six
+    // times the threshold. Smaller buffers come from the resource that was current before.
+    // Numbers created inside the scope must not outlive it. Throws std::system_error if the
+    // directory cannot be written to
+    class ScopedSwap {
+    public:
+        static constexpr size_t DEFAULT_THRESHOLD = size_t(64) << 20;
+
+        explicit ScopedSwap(const std::string& directory, size_t threshold = DEFAULT_THRESHOLD);
+        ScopedSwap(const ScopedSwap&) = delete;
+        ScopedSwap& operator=(const ScopedSwap&) = delete;
+        ~ScopedSwap();
+
+        // Bytes of the buffers in files now, and the most at once since the start of the scope
+        size_t mappedBytes(void) const;
+        size_t peakBytes(void) const;
+
+    private:
+        std::unique_ptr<std::pmr::memory_resource> resource;
+        std::pmr::memory_resource* previous;
+    };
+
+    // A number prepared for dividing many numbers by it, see below
+    class Divisor;
+
+    LongNum(long long number);
+    explicit LongNum(long double number);
+    explicit LongNum(unsigned long long x);
+    LongNum(long double number, uint32_t precision);
+    // Decimal "-123.456" (the fraction is rounded to the nearest at the given precision) or,
+    // with a 0x prefix, hexadecimal "0x7b.74bc" (extra fractional bits are cut off)
+    LongNum(std::string_view number, uint32_t precision);
+    static LongNum fromHex(std::string_view number, uint32_t precision);
+    LongNum(const LongNum& other) = default;
+    LongNum(LongNum&& other) noexcept = default;
+    ~LongNum() = default;
+
+
+    LongNum& operator=(const LongNum& other);
+    LongNum& operator=(LongNum&& other) = default;
+
+    LongNum& operator<<=(uint32_t shift);
+    friend LongNum operator<<(const LongNum& number, unsigned shift);
+    friend LongNum operator<<(LongNum&& number, unsigned shift);
+
+    LongNum& operator>>=(uint32_t shift);
+    friend LongNum operator>>(const LongNum& number, unsigned shift);
+    friend LongNum operator>>(LongNum&& number, unsigned shift);
+
+    LongNum operator+() const;
+    LongNum operator-() const &;
+    LongNum operator-() &&;
+
+    LongNum& operator+=(const LongNum& other);
+    LongNum& operator-=(const LongNum& other);
+    LongNum& operator*=(const LongNum& other);
+    LongNum& operator/=(const LongNum& other);
+
+    friend LongNum operator+(const LongNum& lnum,const LongNum& rnum);
+    friend LongNum operator-(const LongNum& lnum,const LongNum& rnum);
+    // Overloads taking a temporary reuse its limbs for the result
+    friend LongNum operator+(LongNum&& lnum, const LongNum& rnum);
+    friend LongNum operator+(const LongNum& lnum, LongNum&& rnum);
+    friend LongNum operator+(LongNum&& lnum, LongNum&& rnum);
+    friend LongNum operator-(LongNum&& lnum, const LongNum& rnum);
+    friend LongNum operator-(const LongNum& lnum, LongNum&& rnum);
+    friend LongNum operator-(LongNum&& lnum, LongNum&& rnum);
+    friend LongNum operator*(const LongNum& lnum,const LongNum& rnum);
+    friend LongNum operator/(const LongNum& lnum,const LongNum& rnum) ;
+
+    // Arithmetic with native integers runs single-limb kernels on the limbs of the LongNum
+    // instead of converting the integer. `x % n` is the remainder of the truncated division
+    // x / n: the integer part is reduced modulo |n|, the fraction and the sign of x are kept
+    template <NativeInteger T>
+    LongNum& operator+=(T other) {
+        addSmall(magnitudeOf(other), std::cmp_less(other, 0));
+        return *this;
+    }
+    template <NativeInteger T>
+    LongNum& operator-=(T other) {
+        // As with LongNum operands, x - 0 turns -0 into +0
+        addSmall(magnitudeOf(other), std::cmp_greater(other, 0));
+        return *this;
+    }
+    template <NativeInteger T>
+    LongNum& operator*=(T other) {
+        mulSmall(magnitudeOf(other), std::cmp_less(other, 0));
+        return *this;
+    }
+    template <NativeInteger T>
+    LongNum& operator/=(T other) {
+        divSmall(magnitudeOf(other), std::cmp_less(other, 0));
+        return *this;
+    }
+    template <NativeInteger T>
+    LongNum& operator%=(T other) {
+        modSmall(magnitudeOf(other));
+        return *this;
+    }
+
+    template <NativeInteger T>
+    friend LongNum operator+(LongNum lnum, T rnum) {
+        return std::move(lnum += rnum);
+    }
+    template <NativeInteger T>
+    friend LongNum operator+(T lnum, LongNum rnum) {
+        return std::move(rnum += lnum);
+    }
+    template <NativeInteger T>
+    friend LongNum operator-(LongNum lnum, T rnum) {
+        return std::move(lnum -= rnum);
+    }
+    template <NativeInteger T>
+    friend LongNum operator-(T lnum, LongNum rnum) {
+        // n - x = -(x - n), both sides are +0 when they are equal
+        return -std::move(rnum -= lnum);
+    }
+    template <NativeInteger T>
+    friend LongNum operator*(LongNum lnum, T rnum) {
+        return std::move(lnum *= rnum);
+    }
+    template <NativeInteger T>
+    friend LongNum operator*(T lnum, LongNum rnum) {
+        return std::move(rnum *= lnum);
+    }
+    template <NativeInteger T>
+    friend LongNum operator/(LongNum lnum, T rnum) {
+        return std::move(lnum /= rnum);
+    }
+    template <NativeInteger T>
+    friend LongNum operator%(LongNum lnum, T rnum) {
+        return std::move(lnum %= rnum);
+    }
+
+
+    std::strong_ordering operator<=>(const LongNum &other) const;
+    std::strong_ordering absCompare(const LongNum &other) const;
+
+    bool operator==(const LongNum &other) const;
+    bool operator!=(const LongNum& other) const;
+    bool operator<(const LongNum& other) const;
+    bool operator>(const LongNum& other) const;
+
+    template <NativeInteger T>
+    std::strong_ordering operator<=>(T other) const {
+        return compareSmall(magnitudeOf(other), std::cmp_less(other, 0));
+    }
+    template <NativeInteger T>
+    bool operator==(T other) const {
+        return (*this <=> other) == std::strong_ordering::equal;
+    }
+
+    // Whether the value is zero, also for -0 from a division. Cheaper than comparing with 0
+    bool isZero(void) const;
+    // -1, 0 or 1
+    int sign(void) const;
+
+
+     // Методы для работы с точностью
+    void setPrecision(uint32_t precision);
+    uint32_t getPrecision() const;
+    LongNum withPrecision(uint32_t precision) const &;
+    LongNum withPrecision(uint32_t precision) &&;
+
+    std::string toString(unsigned decimalPrecision = UINT32_MAX) const;
+    // Binary form, exact and less than half the size of the decimal one: a 24-byte header
+    // ("LNUM", format version, sign, precision, limb count), the limbs and a checksum, all
+    // little-endian. read() throws std::invalid_argument for data in another format, cut short
+    // or with a wrong checksum. LongNumView maps such a file instead of reading it
+    void write(std::ostream& out) const;
+    static LongNum read(std::istream& in);
+    LongNum abs(void) const &;
+    LongNum abs(void) &&;
+    // *this * *this with the squaring kernels, which operator* also uses when both operands
+    // are the same number
+    LongNum square(void) const;
+    LongNum pow(uint32_t power) const;
+    // lnum * rnum truncated to `precision` binary places, the same as (lnum * rnum).withPrecision(precision)
+    // but the limbs below the precision are mostly not computed. operator* does the same at the
+    // precision of its result
+    static LongNum mulTruncated(const LongNum& lnum, const LongNum& rnum, uint32_t precision);
+    // Square root truncated to the precision of the number
+    LongNum sqrt(void) const;
+    // floor(sqrt(n)) for the integer part n of the number, sqrtRem also gives n - floor(sqrt(n))^2.
+    // A Newton iteration for the inverse square root with precision doubling, without divisions
+    LongNum isqrt(void) const;
+    std::pair<LongNum, LongNum> sqrtRem(void) const;
+
+    static const Thresholds& getThresholds(void);
+    static void setThresholds(const Thresholds& thresholds);
+    // Threads used by large multiplications and conversions (1 by default). Must not be
+    // changed while other threads are computing
+    static unsigned getThreads(void);
+    static void setThreads(unsigned threads);
+
+    // Counters of calls, operand limbs and time per operation and algorithm tier, and of the limb
+    // buffers allocated, over all threads since the last reset. Collected only when the library
+    // is built with -DLONGNUM_STATS=1, otherwise the snapshot is empty. Printable with <<
+    using Stats = stats::Snapshot;
+    static Stats stats(void);
+    static void resetStats(void);
+
+    void printDigits(void);
+    void printBinaryDigits(void);
+
+ };
+
+// A number prepared for dividing many numbers by it: the reciprocal (or, for a single limb,
+// the inverse) of its limbs is computed once instead of in every division. Copies share it
+class LongNum::Divisor {
+public:
+    explicit Divisor(const LongNum& value);
+
+    const LongNum& value(void) const {
+        return divisor;
+    }
+    // number / value(), the same as operator/
+    LongNum divide(const LongNum& number) const;
+    // The integer quotient of the truncated division trunc(number / value()), and
+    // number - quotient * value(), which has the sign of number
+    LongNum quotient(const LongNum& number) const;
+    LongNum remainder(const LongNum& number) const;
+    std::pair<LongNum, LongNum> divmod(const LongNum& number) const;
+
+private:
+    LongNum divisor;
+    // |value| without its low zero limbs, which are dropped from the dividends instead
+    std::shared_ptr<const limbs::Divisor> prepared;
+    size_t zeroLimbs;
+
+    // floor(|number| * B^offset / |value|) into out, resized to at least the quotient limbs
+    void quotientInto(LimbVector& out, const LongNum& number, ptrdiff_t offset) const;
+};
+
+ LongNum operator""_longnum(long double number);
+ LongNum operator""_longnum(unsigned long long number);
+#endif
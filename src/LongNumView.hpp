@@ -0,0 +1,37 @@
+#ifndef LONGNUM_VIEW_H
+#define LONGNUM_VIEW_H
+#include "LongNum.hpp"
+#include <cstddef>
+#include <string>
+
+// A number saved by LongNum::write, mapped into memory read-only instead of being read. Opening
+// checks the header and the size of the file, not the checksum, so it takes the same time for any
+// size and the pages are only read when the limbs are used. value() is a LongNum whose limbs are
+// those of the mapping: it can be an operand of any operation without copying them, and copies
+// of it have limbs of their own, which outlive the view. Needs mmap and a little-endian platform
+class LongNumView {
+public:
+    // Throws std::system_error if the file cannot be mapped and std::invalid_argument if it is
+    // not in the format of LongNum::write
+    explicit LongNumView(const std::string& path);
+    LongNumView(const LongNumView&) = delete;
+    LongNumView& operator=(const LongNumView&) = delete;
+    LongNumView(LongNumView&& other) noexcept;
+    LongNumView& operator=(LongNumView&& other) noexcept;
+    ~LongNumView();
+
+    const LongNum& value(void) const {
+        return number;
+    }
+    // Whether the checksum matches, reads the whole file
+    bool verify(void) const;
+
+private:
+    void* mapping = nullptr;
+    size_t length = 0;
+    LongNum number = 0LL;
+
+    void unmap(void);
+};
+
+#endif
@@ -0,0 +1,805 @@
+#include "Limbs.hpp"
+#include "LongNum.hpp"
+#include "Parallel.hpp"
+#include "Swap.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Multiplication engine. The operands are dispatched by the size of the shorter one:
+// schoolbook below LongNum::Thresholds::karatsuba, then Karatsuba, Toom-3, Toom-4 and
+// finally a three-prime number-theoretic transform. Once the shorter operand reaches PARALLEL_LIMBS,
+// the independent sub-products are spread over the thread pool. Under LongNum::ScopedSwap operands
+// longer than a block of the swap files are multiplied block by block instead.
+
+namespace {
+
+using Limbs = limbs::Buffer;
+
+void mulDispatch(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+void sqrDispatch(uint32_t* out, const uint32_t* a, size_t n);
+
+constexpr size_t PARALLEL_LIMBS = 500;
+
+bool isParallel(size_t nb) {
+    return nb >= PARALLEL_LIMBS && parallel::threads() > 1;
+}
+
+// ****** Helpers ******
+
+using limbs::addInto;
+using limbs::subInto;
+using limbs::significantSize;
+
+// Signed magnitude value used for Toom-Cook evaluation and interpolation
+struct Signed {
+    Limbs mag;
+    bool isNegative = false;
+};
+
+void normalize(Signed& x) {
+    x.mag.resize(significantSize(x.mag.data(), x.mag.size()));
+    if (x.mag.empty()) {
+        x.isNegative = false;
+    }
+}
+
+int compareMagnitude(const Limbs& a, const Limbs& b) {
+    if (a.size() != b.size()) {
+        return a.size() < b.size() ? -1 : 1;
+    }
+    return limbs::cmp(a.data(), b.data(), a.size());
+}
+
+Signed add(const Signed& a, const Signed& b) {
+    Signed result;
+    if (a.isNegative == b.isNegative) {
+        const Limbs& longer = a.mag.size() >= b.mag.size() ? a.mag : b.mag;
+        const Limbs& shorter = a.mag.size() >= b.mag.size() ? b.mag : a.mag;
+        result.mag.assign(longer.size() + 1, 0);
+        std::copy(longer.begin(), longer.end(), result.mag.begin());
+        addInto(result.mag.data(), result.mag.size(), shorter.data(), shorter.size());
+        result.isNegative = a.isNegative;
+    } else {
+        const int ordering = compareMagnitude(a.mag, b.mag);
+        const Signed& greater = ordering >= 0 ? a : b;
+        const Signed& lower = ordering >= 0 ? b : a;
+        result.mag = greater.mag;
+        subInto(result.mag.data(), result.mag.size(), lower.mag.data(), lower.mag.size());
+        result.isNegative = greater.isNegative;
+    }
+    normalize(result);
+    return result;
+}
+
+Signed sub(const Signed& a, Signed b) {
+    b.isNegative = !b.isNegative;
+    return add(a, b);
+}
+
+// |factor| < 2^32
+Signed mulSmall(const Signed& a, int64_t factor) {
+    if (factor == 1 || factor == -1) {
+        Signed result = a;
+        result.isNegative ^= factor < 0;
+        normalize(result);
+        return result;
+    }
+    Signed result;
+    const uint64_t m = factor < 0 ? -factor : factor;
+    result.mag.resize(a.mag.size() + 1);
+    result.mag.back() = limbs::mul1(result.mag.data(), a.mag.data(), a.mag.size(), static_cast<uint32_t>(m));
+    result.isNegative = a.isNegative ^ (factor < 0);
+    normalize(result);
+    return result;
+}
+
+// a /= divisor, the division must be exact. Odd divisors are handled by multiplying by
+// their inverse modulo 2^32 from the low limb upwards, which avoids hardware division
+void divExact(Signed& a, int64_t divisor) {
+    a.isNegative ^= divisor < 0;
+    uint32_t d = static_cast<uint32_t>(divisor < 0 ? -divisor : divisor);
+    const unsigned twos = std::countr_zero(d);
+    d >>= twos;
+    if (d != 1) {
+        uint32_t inverse = d;
+        for (int i = 0; i < 5; i++) {
+            inverse *= 2 - d * inverse;
+        }
+        uint32_t carry = 0;
+        for (uint32_t& limb : a.mag) {
+            const uint32_t borrow = limb < carry;
+            const uint32_t q = (limb - carry) * inverse;
+            limb = q;
+            carry = static_cast<uint32_t>((static_cast<uint64_t>(q) * d) >> 32) + borrow;
+        }
+    }
+    limbs::rshift(a.mag.data(), a.mag.data(), a.mag.size(), twos);
+    normalize(a);
+}
+
+Signed mulSigned(const Signed& a, const Signed& b) {
+    Signed result;
+    if (a.mag.empty() || b.mag.empty()) {
+        return result;
+    }
+    result.mag.resize(a.mag.size() + b.mag.size());
+    mulDispatch(result.mag.data(), a.mag.data(), a.mag.size(), b.mag.data(), b.mag.size());
+    result.isNegative = a.isNegative ^ b.isNegative;
+    normalize(result);
+    return result;
+}
+
+// ****** Algorithms ******
+
+#if LONGNUM_WIDE_KERNELS
+// out[0..n) += b[0..n) * digit, returns the carry out of the top limb
+uint64_t addMulRow(uint32_t* out, const uint32_t* b, size_t n, uint64_t digit) {
+    uint64_t carry = 0;
+    size_t j = 0;
+    for (; j + 1 < n; j += 2) {
+        const limbs::uint128_t cur = static_cast<limbs::uint128_t>(digit) * limbs::loadWord(b + j) +
+                                     limbs::loadWord(out + j) + carry;
+        limbs::storeWord(out + j, static_cast<uint64_t>(cur));
+        carry = static_cast<uint64_t>(cur >> 64);
+    }
+    if (j < n) {
+        const limbs::uint128_t cur = static_cast<limbs::uint128_t>(digit) * b[j] + out[j] + carry;
+        out[j] = static_cast<uint32_t>(cur);
+        carry = static_cast<uint64_t>(cur >> 32);
+    }
+    return carry;
+}
+
+// Rows of two limbs of a at a time
+void mulBasecase(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    std::fill(out, out + na + nb, 0);
+    size_t i = 0;
+    for (; i + 1 < na; i += 2) {
+        limbs::storeWord(out + i + nb, addMulRow(out + i, b, nb, limbs::loadWord(a + i)));
+    }
+    if (i < na) {
+        out[i + nb] = static_cast<uint32_t>(addMulRow(out + i, b, nb, a[i]));
+    }
+}
+
+// The products of different two-limb digits once, doubled, then the squares of the digits
+void sqrBasecase(uint32_t* out, const uint32_t* a, size_t n) {
+    std::fill(out, out + 2 * n, 0);
+    for (size_t i = 0; i + 2 < n; i += 2) {
+        limbs::storeWord(out + i + n, addMulRow(out + 2 * i + 2, a + i + 2, n - i - 2, limbs::loadWord(a + i)));
+    }
+    // Doubling and adding the squares in one pass, `shifted` is the bit moved into the next word
+    uint64_t shifted = 0;
+    unsigned char carry = 0;
+    size_t i = 0;
+    for (; i + 1 < n; i += 2) {
+        const uint64_t digit = limbs::loadWord(a + i);
+        const limbs::uint128_t square = static_cast<limbs::uint128_t>(digit) * digit;
+        const uint64_t low = limbs::loadWord(out + 2 * i), high = limbs::loadWord(out + 2 * i + 2);
+        limbs::storeWord(out + 2 * i, limbs::addCarry((low << 1) | shifted, static_cast<uint64_t>(square), carry));
+        limbs::storeWord(out + 2 * i + 2, limbs::addCarry((high << 1) | (low >> 63), static_cast<uint64_t>(square >> 64), carry));
+        shifted = high >> 63;
+    }
+    if (i < n) {
+        const uint64_t square = static_cast<uint64_t>(a[i]) * a[i];
+        const uint64_t low = limbs::loadWord(out + 2 * i);
+        limbs::storeWord(out + 2 * i, limbs::addCarry((low << 1) | shifted, square, carry));
+    }
+}
+#else
+void mulBasecase(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    out[nb] = limbs::mul1(out, b, nb, a[0]);
+    for (size_t i = 1; i < na; i++) {
+        out[i + nb] = limbs::addmul1(out + i, b, nb, a[i]);
+    }
+}
+
+// The products of different limbs once, doubled, then the squares of the limbs
+void sqrBasecase(uint32_t* out, const uint32_t* a, size_t n) {
+    std::fill(out, out + 2 * n, 0);
+    for (size_t i = 0; i + 1 < n; i++) {
+        out[i + n] = limbs::addmul1(out + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    limbs::lshift(out, out, 2 * n, 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t square = static_cast<uint64_t>(a[i]) * a[i];
+        const uint64_t low = static_cast<uint64_t>(out[2 * i]) + static_cast<uint32_t>(square) + carry;
+        out[2 * i] = static_cast<uint32_t>(low);
+        const uint64_t high = static_cast<uint64_t>(out[2 * i + 1]) + (square >> 32) + (low >> 32);
+        out[2 * i + 1] = static_cast<uint32_t>(high);
+        carry = high >> 32;
+    }
+}
+#endif
+
+// Splits a into nb-sized chunks and multiplies each of them by b
+void mulUnbalanced(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (isParallel(nb)) {
+        // Products of even chunks do not overlap each other, neither do the odd ones
+        const size_t size = na + nb;
+        const size_t chunks = (na + nb - 1) / nb;
+        Limbs odd(size, 0);
+        std::fill(out, out + size, 0);
+        parallel::forEach(chunks, [&](size_t i) {
+            const size_t offset = i * nb;
+            const size_t len = std::min(nb, na - offset);
+            mulDispatch((i & 1 ? odd.data() : out) + offset, a + offset, len, b, nb);
+        });
+        addInto(out + nb, size - nb, odd.data() + nb, size - nb);
+        return;
+    }
+    mulDispatch(out, a, nb, b, nb);
+    std::fill(out + 2 * nb, out + na + nb, 0);
+    Limbs tmp(2 * nb);
+    for (size_t offset = nb; offset < na; offset += nb) {
+        const size_t len = std::min(nb, na - offset);
+        mulDispatch(tmp.data(), a + offset, len, b, nb);
+        addInto(out + offset, na + nb - offset, tmp.data(), len + nb);
+    }
+}
+
+// na >= nb > na / 2
+void mulKaratsuba(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    const size_t h = (na + 1) / 2;
+    if (nb <= h) {
+        mulUnbalanced(out, a, na, b, nb);
+        return;
+    }
+    const size_t size = na + nb;
+
+    Limbs sumA(h + 1, 0), sumB(h + 1, 0);
+    std::copy(a, a + h, sumA.begin());
+    addInto(sumA.data(), h + 1, a + h, na - h);
+    std::copy(b, b + h, sumB.begin());
+    addInto(sumB.data(), h + 1, b + h, nb - h);
+    const size_t lenA = significantSize(sumA.data(), h + 1);
+    const size_t lenB = significantSize(sumB.data(), h + 1);
+
+    Limbs middle(lenA + lenB);
+    auto mulMiddle = [&] { mulDispatch(middle.data(), sumA.data(), lenA, sumB.data(), lenB); };
+    auto mulLow = [&] { mulDispatch(out, a, h, b, h); };
+    auto mulHigh = [&] { mulDispatch(out + 2 * h, a + h, na - h, b + h, nb - h); };
+    if (isParallel(nb)) {
+        parallel::invoke(mulMiddle, mulLow, mulHigh);
+    } else {
+        mulMiddle();
+        mulLow();
+        mulHigh();
+    }
+
+    subInto(middle.data(), middle.size(), out, significantSize(out, 2 * h));
+    subInto(middle.data(), middle.size(), out + 2 * h, significantSize(out + 2 * h, size - 2 * h));
+    addInto(out + h, size - h, middle.data(), significantSize(middle.data(), middle.size()));
+}
+
+// a^2 = a1^2 B^2h + (a0^2 + a1^2 - |a0 - a1|^2) B^h + a0^2, which needs no carry limb
+// in the middle square
+void sqrKaratsuba(uint32_t* out, const uint32_t* a, size_t n) {
+    const size_t h = (n + 1) / 2;
+    const size_t size = 2 * n;
+
+    // |a0 - a1|, where a1 = a[h..n) may be one limb shorter than a0
+    Limbs diff(h);
+    const bool lowGreater = (n - h < h && a[h - 1] != 0) || limbs::cmp(a, a + h, n - h) >= 0;
+    if (lowGreater) {
+        limbs::sub1(diff.data() + (n - h), a + (n - h), h - (n - h), limbs::subN(diff.data(), a, a + h, n - h));
+    } else {
+        // Here the top limb of a0 is zero if a1 is shorter
+        limbs::subN(diff.data(), a + h, a, n - h);
+        if (n - h < h) {
+            diff[h - 1] = 0;
+        }
+    }
+    const size_t lenDiff = significantSize(diff.data(), h);
+
+    Limbs middle(2 * h + 1, 0);
+    auto sqrMiddle = [&] { sqrDispatch(middle.data(), diff.data(), lenDiff); };
+    auto sqrLow = [&] { sqrDispatch(out, a, h); };
+    auto sqrHigh = [&] { sqrDispatch(out + 2 * h, a + h, n - h); };
+    if (isParallel(n)) {
+        parallel::invoke(sqrMiddle, sqrLow, sqrHigh);
+    } else {
+        sqrMiddle();
+        sqrLow();
+        sqrHigh();
+    }
+
+    // middle = a0^2 - middle + a1^2 = 2 a0 a1, the intermediate borrow wraps around in 2h + 1 limbs
+    middle[2 * h] = -limbs::subN(middle.data(), out, middle.data(), 2 * h);
+    addInto(middle.data(), middle.size(), out + 2 * h, significantSize(out + 2 * h, size - 2 * h));
+    addInto(out + h, size - h, middle.data(), significantSize(middle.data(), middle.size()));
+}
+
+// Toom-k with k = (points.size() + 2) / 2: evaluates both operands at the given finite points and
+// at infinity, multiplies pointwise and interpolates with Newton divided differences. A square
+// (a == b) is evaluated once and squared pointwise.
+// na >= nb > na / 2
+void mulToomCook(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb,
+                 const std::vector<int64_t>& points) {
+    const size_t k = (points.size() + 2) / 2;
+    const size_t s = (na + k - 1) / k;
+    const size_t size = na + nb;
+
+    auto split = [s, k](const uint32_t* x, size_t n) {
+        std::vector<Signed> parts(k);
+        for (size_t i = 0; i < k && i * s < n; i++) {
+            parts[i].mag.assign(x + i * s, x + std::min(n, (i + 1) * s));
+            normalize(parts[i]);
+        }
+        return parts;
+    };
+    auto evaluate = [k](const std::vector<Signed>& parts, int64_t point) {
+        Signed acc = parts[k - 1];
+        for (size_t i = k - 1; i-- > 0;) {
+            acc = add(mulSmall(acc, point), parts[i]);
+        }
+        return acc;
+    };
+    const bool square = a == b && na == nb;
+    const std::vector<Signed> partsA = split(a, na);
+    const std::vector<Signed> partsB = square ? std::vector<Signed>() : split(b, nb);
+
+    const size_t m = points.size();
+    Signed atInfinity;
+    std::vector<Signed> values(m);
+    auto pointwise = [&](size_t i) {
+        // mulSigned of a number with itself squares it
+        if (i == m) {
+            atInfinity = mulSigned(partsA[k - 1], square ? partsA[k - 1] : partsB[k - 1]);
+        } else if (square) {
+            const Signed value = evaluate(partsA, points[i]);
+            values[i] = mulSigned(value, value);
+        } else {
+            values[i] = mulSigned(evaluate(partsA, points[i]), evaluate(partsB, points[i]));
+        }
+    };
+    if (isParallel(nb)) {
+        parallel::forEach(m + 1, pointwise);
+    } else {
+        for (size_t i = 0; i <= m; i++) {
+            pointwise(i);
+        }
+    }
+    for (size_t i = 0; i < m; i++) {
+        int64_t power = 1;
+        for (size_t j = 0; j < m; j++) {
+            power *= points[i];
+        }
+        values[i] = sub(values[i], mulSmall(atInfinity, power));
+    }
+
+    // Newton divided differences of the remaining polynomial of degree m - 1
+    for (size_t j = 1; j < m; j++) {
+        for (size_t i = m - 1; i >= j; i--) {
+            values[i] = sub(values[i], values[i - 1]);
+            divExact(values[i], points[i] - points[i - j]);
+        }
+    }
+
+    // Newton form to coefficients
+    std::vector<Signed> coefficients = {values[m - 1]};
+    for (size_t i = m - 1; i-- > 0;) {
+        std::vector<Signed> next(coefficients.size() + 1);
+        next.back() = coefficients.back();
+        for (size_t j = coefficients.size() - 1; j > 0; j--) {
+            next[j] = sub(coefficients[j - 1], mulSmall(coefficients[j], points[i]));
+        }
+        next[0] = add(mulSmall(coefficients[0], -points[i]), values[i]);
+        coefficients = std::move(next);
+    }
+    coefficients.push_back(atInfinity);
+
+    std::fill(out, out + size, 0);
+    for (size_t i = 0; i < coefficients.size(); i++) {
+        const Limbs& c = coefficients[i].mag;
+        if (!c.empty()) {
+            addInto(out + i * s, size - i * s, c.data(), c.size());
+        }
+    }
+}
+
+// ****** Number-theoretic transform ******
+
+// Arithmetic modulo a prime P < 2^31 with Montgomery multiplication (R = 2^32)
+template <uint32_t P, uint32_t G>
+struct Modular {
+    static constexpr uint32_t MOD = P;
+    static constexpr uint32_t ROOT = G;
+
+    static constexpr uint32_t negInverse() {
+        uint32_t inverse = P;
+        for (int i = 0; i < 5; i++) {
+            inverse *= 2 - P * inverse;
+        }
+        return -inverse;
+    }
+    static constexpr uint32_t NEG_INVERSE = negInverse();
+    static constexpr uint32_t R2 = static_cast<uint32_t>((static_cast<limbs::uint128_t>(1) << 64) % P);
+
+    // a * b / R mod P
+    static uint32_t mul(uint32_t a, uint32_t b) {
+        const uint64_t t = static_cast<uint64_t>(a) * b;
+        const uint32_t m = static_cast<uint32_t>(t) * NEG_INVERSE;
+        const uint32_t u = static_cast<uint32_t>((t + static_cast<uint64_t>(m) * P) >> 32);
+        return u >= P ? u - P : u;
+    }
+    static uint32_t add(uint32_t a, uint32_t b) {
+        const uint32_t sum = a + b;
+        return sum >= P ? sum - P : sum;
+    }
+    static uint32_t sub(uint32_t a, uint32_t b) {
+        return a >= b ? a - b : a + P - b;
+    }
+    static uint32_t toMontgomery(uint32_t a) {
+        return mul(a, R2);
+    }
+    // Plain (non-Montgomery) exponentiation
+    static uint32_t pow(uint64_t base, uint64_t power) {
+        uint64_t result = 1;
+        base %= P;
+        while (power) {
+            if (power & 1) {
+                result = result * base % P;
+            }
+            base = base * base % P;
+            power >>= 1;
+        }
+        return static_cast<uint32_t>(result);
+    }
+};
+
+using Mod1 = Modular<2013265921, 31>;  // 15 * 2^27 + 1
+using Mod2 = Modular<469762049, 3>;    //  7 * 2^26 + 1
+using Mod3 = Modular<754974721, 11>;   // 45 * 2^24 + 1
+
+// Largest transform length supported by all three primes. Convolution terms are bounded by
+// 2^23 * (2^32 - 1)^2 < 2^87, which is below the product of the primes (about 2^89.2)
+constexpr size_t MAX_NTT_LENGTH = size_t(1) << 24;
+
+// roots[len + j] = w^j in Montgomery form, where w is a primitive 2len-th root of unity
+template <typename M>
+Limbs rootTable(size_t n, bool inverse) {
+    Limbs roots(std::max<size_t>(n, 2));
+    for (size_t len = 1; len < n; len <<= 1) {
+        uint32_t w = M::pow(M::ROOT, (M::MOD - 1) / (2 * len));
+        if (inverse) {
+            w = M::pow(w, M::MOD - 2);
+        }
+        const uint32_t step = M::toMontgomery(w);
+        uint32_t cur = M::toMontgomery(1);
+        for (size_t j = 0; j < len; j++) {
+            roots[len + j] = cur;
+            cur = M::mul(cur, step);
+        }
+    }
+    return roots;
+}
+
+// Decimation in frequency: natural order in, bit-reversed order out
+template <typename M>
+void forwardTransform(Limbs& a, const Limbs& roots) {
+    const size_t n = a.size();
+    for (size_t len = n / 2; len >= 1; len >>= 1) {
+        const uint32_t* w = roots.data() + len;
+        for (size_t i = 0; i < n; i += 2 * len) {
+            uint32_t* x = a.data() + i;
+            uint32_t* y = x + len;
+            for (size_t j = 0; j < len; j++) {
+                const uint32_t u = x[j], v = y[j];
+                x[j] = M::add(u, v);
+                y[j] = M::mul(M::sub(u, v), w[j]);
+            }
+        }
+    }
+}
+
+// Decimation in time: bit-reversed order in, natural order out (without the 1/n factor)
+template <typename M>
+void inverseTransform(Limbs& a, const Limbs& roots) {
+    const size_t n = a.size();
+    for (size_t len = 1; len < n; len <<= 1) {
+        const uint32_t* w = roots.data() + len;
+        for (size_t i = 0; i < n; i += 2 * len) {
+            uint32_t* x = a.data() + i;
+            uint32_t* y = x + len;
+            for (size_t j = 0; j < len; j++) {
+                const uint32_t u = x[j], v = M::mul(y[j], w[j]);
+                x[j] = M::add(u, v);
+                y[j] = M::sub(u, v);
+            }
+        }
+    }
+}
+
+// Cyclic convolution of a and b modulo M::MOD of length n, the first na + nb residues are returned.
+// A square (a == b) takes a single forward transform
+template <typename M>
+Limbs convolve(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t n) {
+    const Limbs roots = rootTable<M>(n, false);
+    Limbs fa(n, 0);
+    for (size_t i = 0; i < na; i++) {
+        fa[i] = a[i] % M::MOD;
+    }
+    if (a == b && na == nb) {
+        forwardTransform<M>(fa, roots);
+        for (size_t i = 0; i < n; i++) {
+            fa[i] = M::mul(fa[i], fa[i]);
+        }
+    } else {
+        Limbs fb(n, 0);
+        for (size_t i = 0; i < nb; i++) {
+            fb[i] = b[i] % M::MOD;
+        }
+        parallel::invoke([&] { forwardTransform<M>(fa, roots); }, [&] { forwardTransform<M>(fb, roots); });
+        for (size_t i = 0; i < n; i++) {
+            fa[i] = M::mul(fa[i], fb[i]);
+        }
+    }
+    inverseTransform<M>(fa, rootTable<M>(n, true));
+    // The pointwise product lost one factor R, so scale by R^2 / n to get plain residues
+    const uint32_t scale = static_cast<uint32_t>(static_cast<uint64_t>(M::pow(n, M::MOD - 2)) * M::R2 % M::MOD);
+    const size_t size = na + nb;
+    fa.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        fa[i] = M::mul(fa[i], scale);
+    }
+    return fa;
+}
+
+// Three-prime NTT multiplication with Garner's CRT reconstruction. na + nb <= MAX_NTT_LENGTH
+void mulNtt(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    const size_t size = na + nb;
+    const size_t n = std::bit_ceil(size);
+    Limbs r1, r2, r3;
+    parallel::invoke([&] { r1 = convolve<Mod1>(a, na, b, nb, n); },
+                     [&] { r2 = convolve<Mod2>(a, na, b, nb, n); },
+                     [&] { r3 = convolve<Mod3>(a, na, b, nb, n); });
+
+    constexpr uint64_t p1 = Mod1::MOD, p2 = Mod2::MOD, p3 = Mod3::MOD;
+    const uint64_t p1InvMod2 = Mod2::pow(p1, p2 - 2);
+    const uint64_t p12InvMod3 = Mod3::pow(p1 * p2 % p3, p3 - 2);
+    const uint64_t p1Mod3 = p1 % p3;
+    const limbs::uint128_t p12 = static_cast<limbs::uint128_t>(p1) * p2;
+
+    limbs::uint128_t carry = 0;
+    for (size_t i = 0; i < size; i++) {
+        const uint64_t v1 = r1[i];
+        const uint64_t v2 = (r2[i] + p2 - v1 % p2) * p1InvMod2 % p2;
+        const uint64_t t = (v1 % p3 + v2 % p3 * p1Mod3) % p3;
+        const uint64_t v3 = (r3[i] + p3 - t) * p12InvMod3 % p3;
+        carry += v1 + static_cast<limbs::uint128_t>(v2) * p1 + v3 * p12;
+        out[i] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+}
+
+// ****** Out-of-core ******
+
+// Product of operands in swap files: the products of pairs of blocks are computed in memory and
+// added to out a diagonal (i + j) at a time, so out is written once from the bottom up, and the
+// blocks of the operands are read whole, the next pair ahead of the current one. The pairs cost
+// more arithmetic than one product of the whole operands, but no transform runs over the files.
+// A square takes the pairs with i <= j and adds the others twice
+void mulBlocked(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t block) {
+    const bool square = a == b && na == nb;
+    const size_t size = na + nb;
+    const size_t blocksA = (na + block - 1) / block;
+    const size_t blocksB = (nb + block - 1) / block;
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (size_t k = 0; k + 1 < blocksA + blocksB; k++) {
+        const size_t first = k >= blocksB ? k - blocksB + 1 : 0;
+        const size_t last = std::min(k, blocksA - 1);
+        for (size_t i = first; i <= last && !(square && k - i < i); i++) {
+            pairs.emplace_back(i, k - i);
+        }
+    }
+    auto blockOf = [block](const uint32_t* x, size_t n, size_t i) {
+        return std::pair(x + i * block, std::min(block, n - i * block));
+    };
+
+    Limbs product(2 * block);
+    // out is zero up to `ready`, a block above the diagonal leaves room for its carries
+    size_t ready = 0;
+    for (size_t p = 0; p < pairs.size(); p++) {
+        const auto [i, j] = pairs[p];
+        const size_t k = i + j;
+        if (p + 1 < pairs.size()) {
+            const auto [x, nx] = blockOf(a, na, pairs[p + 1].first);
+            const auto [y, ny] = blockOf(b, nb, pairs[p + 1].second);
+            swap::willNeed(x, nx);
+            swap::willNeed(y, ny);
+        }
+        const size_t end = std::min(size, (k + 3) * block);
+        if (ready < end) {
+            std::fill(out + ready, out + end, 0);
+            ready = end;
+        }
+        const auto [x, nx] = blockOf(a, na, i);
+        const auto [y, ny] = blockOf(b, nb, j);
+        mulDispatch(product.data(), x, nx, y, ny);
+        swap::addInto(out + k * block, ready - k * block, product.data(), nx + ny);
+        if (square && i != j) {
+            swap::addInto(out + k * block, ready - k * block, product.data(), nx + ny);
+        }
+        // The limbs below the next diagonal are final
+        if (p + 1 == pairs.size() || pairs[p + 1].first + pairs[p + 1].second != k) {
+            swap::evict(out + k * block, std::min(block, size - k * block));
+        }
+    }
+}
+
+void mulDispatch(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (a == b && na == nb) {
+        sqrDispatch(out, a, na);
+        return;
+    }
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (nb == 0) {
+        std::fill(out, out + na, 0);
+        return;
+    }
+    const LongNum::Thresholds& thresholds = LongNum::getThresholds();
+    if (nb < thresholds.karatsuba) {
+        stats::Scope scope(stats::Tier::Schoolbook, na + nb);
+        mulBasecase(out, a, na, b, nb);
+    } else if (const size_t block = swap::blockFor(nb)) {
+        stats::Scope scope(stats::Tier::Blocked, na + nb);
+        mulBlocked(out, a, na, b, nb, block);
+    } else if (na >= 2 * nb) {
+        mulUnbalanced(out, a, na, b, nb);
+    } else if (nb >= thresholds.ntt && na + nb <= MAX_NTT_LENGTH) {
+        stats::Scope scope(stats::Tier::Ntt, na + nb);
+        mulNtt(out, a, na, b, nb);
+    } else if (nb < thresholds.toom3) {
+        stats::Scope scope(stats::Tier::Karatsuba, na + nb);
+        mulKaratsuba(out, a, na, b, nb);
+    } else if (nb < thresholds.toom4) {
+        stats::Scope scope(stats::Tier::Toom3, na + nb);
+        static const std::vector<int64_t> toom3Points = {0, 1, -1, 2};
+        mulToomCook(out, a, na, b, nb, toom3Points);
+    } else {
+        stats::Scope scope(stats::Tier::Toom4, na + nb);
+        static const std::vector<int64_t> toom4Points = {0, 1, -1, 2, -2, 3};
+        mulToomCook(out, a, na, b, nb, toom4Points);
+    }
+}
+
+// Squares take the same tiers at the same sizes as products
+void sqrDispatch(uint32_t* out, const uint32_t* a, size_t n) {
+    if (n == 0) {
+        return;
+    }
+    const LongNum::Thresholds& thresholds = LongNum::getThresholds();
+    if (n < thresholds.karatsuba) {
+        stats::Scope scope(stats::Tier::Schoolbook, 2 * n);
+        sqrBasecase(out, a, n);
+    } else if (const size_t block = swap::blockFor(n)) {
+        stats::Scope scope(stats::Tier::Blocked, 2 * n);
+        mulBlocked(out, a, n, a, n, block);
+    } else if (n >= thresholds.ntt && 2 * n <= MAX_NTT_LENGTH) {
+        stats::Scope scope(stats::Tier::Ntt, 2 * n);
+        mulNtt(out, a, n, a, n);
+    } else if (n < thresholds.toom3) {
+        stats::Scope scope(stats::Tier::Karatsuba, 2 * n);
+        sqrKaratsuba(out, a, n);
+    } else if (n < thresholds.toom4) {
+        stats::Scope scope(stats::Tier::Toom3, 2 * n);
+        static const std::vector<int64_t> toom3Points = {0, 1, -1, 2};
+        mulToomCook(out, a, n, a, n, toom3Points);
+    } else {
+        stats::Scope scope(stats::Tier::Toom4, 2 * n);
+        static const std::vector<int64_t> toom4Points = {0, 1, -1, 2, -2, 3};
+        mulToomCook(out, a, n, a, n, toom4Points);
+    }
+}
+
+// ****** Short product ******
+
+// Limbs below the skipped ones that are computed to bound the error of the short product
+constexpr size_t GUARD_LIMBS = 2;
+
+// [out, end) += a * b
+void addProduct(uint32_t* out, uint32_t* end, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    Limbs product(na + nb);
+    mulDispatch(product.data(), a, na, b, nb);
+    addInto(out, end - out, product.data(), na + nb);
+}
+
+// Schoolbook rows of addShortProduct, each one starting at the diagonal
+#if LONGNUM_WIDE_KERNELS
+void addShortBasecase(uint32_t* out, uint32_t* end, const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t k) {
+    size_t i = 0;
+    for (; i + 1 < na; i += 2) {
+        const size_t start = i + 1 < k ? k - i - 1 : 0;
+        const uint64_t carry = addMulRow(out + i + start, b + start, nb - start, limbs::loadWord(a + i));
+        const uint32_t carryLimbs[2] = {static_cast<uint32_t>(carry), static_cast<uint32_t>(carry >> 32)};
+        addInto(out + i + nb, end - (out + i + nb), carryLimbs, 2);
+    }
+    if (i < na) {
+        const size_t start = i < k ? k - i : 0;
+        const uint32_t carry = limbs::addmul1(out + i + start, b + start, nb - start, a[i]);
+        addInto(out + i + nb, end - (out + i + nb), &carry, 1);
+    }
+}
+#else
+void addShortBasecase(uint32_t* out, uint32_t* end, const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t k) {
+    for (size_t i = 0; i < na; i++) {
+        const size_t start = i < k ? k - i : 0;
+        const uint32_t carry = limbs::addmul1(out + i + start, b + start, nb - start, a[i]);
+        addInto(out + i + nb, end - (out + i + nb), &carry, 1);
+    }
+}
+#endif
+
+// [out, end) += the partial products a[i] * b[j] * B^(i+j) of a set that contains all of them with
+// i + j >= k and possibly some with lower columns, each one once. Follows Mulders: a full product of
+// the high ~70% of both operands and two short products for the strips left of the diagonal,
+// schoolbook rows that start at the diagonal for small operands
+void addShortProduct(uint32_t* out, uint32_t* end, const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t k) {
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (na == 0 || k > na + nb - 2) {
+        return;
+    }
+    // Limbs of either operand whose products all stay below column k are not needed
+    if (k > nb - 1) {
+        const size_t low = k - (nb - 1);
+        a += low, na -= low, out += low, k -= low;
+    }
+    if (k > na - 1) {
+        const size_t low = k - (na - 1);
+        b += low, nb -= low, out += low, k -= low;
+    }
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    const LongNum::Thresholds& thresholds = LongNum::getThresholds();
+    if (k == 0 || na >= thresholds.toom4) {
+        // Above Toom-4 the smaller full products do not make up for the extra ones
+        addProduct(out, end, a, na, b, nb);
+    } else if (na < thresholds.karatsuba) {
+        stats::Scope scope(stats::Tier::Schoolbook, na + nb);
+        addShortBasecase(out, end, a, na, b, nb, k);
+    } else {
+        const size_t split = k * 3 / 10;
+        addProduct(out + 2 * split, end, a + split, na - split, b + split, nb - split);
+        addShortProduct(out, end, a, split, b, nb, k);
+        addShortProduct(out + split, end, a + split, na - split, b, split, k - split);
+    }
+}
+
+}
+
+void limbs::mul(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    mulDispatch(out, a, na, b, nb);
+}
+
+void limbs::sqr(uint32_t* out, const uint32_t* a, size_t n) {
+    sqrDispatch(out, a, n);
+}
+
+void limbs::mulHigh(uint32_t* out, const uint32_t* a, size_t na, const uint32_t* b, size_t nb, size_t skip) {
+    // Squares skip half of the products anyway, so they are computed in full
+    const bool square = a == b && na == nb;
+    if (!square && skip > GUARD_LIMBS && std::min(na, nb) < LongNum::getThresholds().toom4) {
+        // The missing products lie in the columns below k and add less than k * B^(k+1) to the
+        // sum, so there is no carry out of the guard limbs while their top one is below B - k
+        const size_t k = skip - GUARD_LIMBS;
+        std::fill(out, out + na + nb, 0);
+        addShortProduct(out, out + na + nb, a, na, b, nb, k);
+        if (static_cast<uint64_t>(out[skip - 1]) + k <= UINT32_MAX) {
+            return;
+        }
+    }
+    mulDispatch(out, a, na, b, nb);
+}
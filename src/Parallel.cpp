@@ -0,0 +1,170 @@
+#include "Parallel.hpp"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+using parallel::Task;
+
+class Pool {
+public:
+    // Queue 0 is shared by the threads outside the pool, workers own queues 1..count-1
+    explicit Pool(unsigned count) : queues(count) {
+        for (auto& queue : queues) {
+            queue = std::make_unique<Queue>();
+        }
+        for (unsigned i = 1; i < count; i++) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ~Pool() {
+        {
+            std::lock_guard lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void runAll(std::vector<Task>& tasks) {
+        pending.fetch_add(tasks.size() - 1);
+        {
+            Queue& own = *queues[self];
+            std::lock_guard lock(own.mutex);
+            for (size_t i = tasks.size(); i-- > 1;) {
+                own.tasks.push_back(&tasks[i]);
+            }
+        }
+        {
+            std::lock_guard lock(sleepMutex);
+        }
+        wake.notify_all();
+
+        run(tasks[0]);
+        for (size_t i = 1; i < tasks.size(); i++) {
+            while (!tasks[i].done.load(std::memory_order_acquire)) {
+                if (Task* task = find()) {
+                    run(*task);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task*> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> pending = 0;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    static thread_local size_t self;
+
+    static void run(Task& task) {
+        std::pmr::memory_resource* const resource = limbs::currentResource;
+        limbs::currentResource = task.resource;
+        try {
+            task.run(task.context, task.index);
+        } catch (...) {
+            task.error = std::current_exception();
+        }
+        limbs::currentResource = resource;
+        task.done.store(true, std::memory_order_release);
+    }
+
+    // The newest task of the own queue, otherwise the oldest one of another queue
+    Task* find(void) {
+        if (pending.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < queues.size(); i++) {
+            Queue& queue = *queues[(self + i) % queues.size()];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                Task* task;
+                if (i == 0) {
+                    task = queue.tasks.back();
+                    queue.tasks.pop_back();
+                } else {
+                    task = queue.tasks.front();
+                    queue.tasks.pop_front();
+                }
+                pending.fetch_sub(1);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    void work(size_t index) {
+        self = index;
+        while (true) {
+            if (Task* task = find()) {
+                run(*task);
+                continue;
+            }
+            std::unique_lock lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || pending.load() > 0; });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+};
+
+thread_local size_t Pool::self = 0;
+
+std::unique_ptr<Pool> pool;
+std::atomic<unsigned> threadCount = 1;
+
+}
+
+void parallel::setThreads(unsigned count) {
+    if (count == 0) {
+        throw std::invalid_argument("Thread count must be positive");
+    }
+    if (count == threadCount) {
+        return;
+    }
+    pool.reset();
+    if (count > 1) {
+        pool = std::make_unique<Pool>(count);
+    }
+    threadCount = count;
+}
+
+unsigned parallel::threads(void) {
+    return threadCount.load(std::memory_order_relaxed);
+}
+
+void parallel::runAll(std::vector<Task>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+    if (!pool || tasks.size() == 1) {
+        for (Task& task : tasks) {
+            task.run(task.context, task.index);
+        }
+        return;
+    }
+    pool->runAll(tasks);
+    for (Task& task : tasks) {
+        if (task.error) {
+            std::rethrow_exception(task.error);
+        }
+    }
+}
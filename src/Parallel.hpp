@@ -0,0 +1,64 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include "Allocator.hpp"
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+#include <vector>
+
+// Fork-join helpers on top of a work-stealing thread pool. Every thread owns a deque of tasks:
+// it pushes and pops its own tasks at the back and steals from the front of the others' deques.
+// A thread waiting for its tasks keeps running queued work instead of blocking, so nested
+// calls (a parallel multiplication inside a parallel subtree) cannot deadlock.
+namespace parallel {
+
+    // Number of threads taking part in the computations, 1 runs everything on the calling thread.
+    // Must not be changed while other threads are computing
+    void setThreads(unsigned count);
+    unsigned threads(void);
+
+    struct Task {
+        void (*run)(void* context, size_t index);
+        void* context;
+        size_t index;
+        // Memory resource of the thread that created the task
+        std::pmr::memory_resource* resource = limbs::currentResource;
+        std::atomic<bool> done = false;
+        std::exception_ptr error;
+    };
+
+    // Runs the tasks and returns once all of them are finished. The first exception is rethrown
+    void runAll(std::vector<Task>& tasks);
+
+    // fn(i) for every i in [0, n), possibly concurrently
+    template <typename F>
+    void forEach(size_t n, F&& fn) {
+        if (n == 1 || threads() == 1) {
+            for (size_t i = 0; i < n; i++) {
+                fn(i);
+            }
+            return;
+        }
+        std::vector<Task> tasks(n);
+        using Function = std::remove_reference_t<F>;
+        for (size_t i = 0; i < n; i++) {
+            tasks[i].run = [](void* context, size_t index) { (*static_cast<Function*>(context))(index); };
+            tasks[i].context = const_cast<void*>(static_cast<const void*>(&fn));
+            tasks[i].index = i;
+        }
+        runAll(tasks);
+    }
+
+    // Calls every function, possibly concurrently
+    template <typename... F>
+    void invoke(F&&... fns) {
+        forEach(sizeof...(F), [&](size_t i) {
+            size_t j = 0;
+            ((j++ == i ? fns() : void()), ...);
+        });
+    }
+
+}
+
+#endif
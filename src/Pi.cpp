@@ -0,0 +1,57 @@
+#include "Pi.hpp"
+#include "Expression.hpp"
+#include "Parallel.hpp"
+#include <cmath>
+
+constexpr long long C = 640320;
+constexpr long long C3_OVER_24 = C * C * C / 24;
+// Subtrees with at least this many terms are evaluated concurrently
+constexpr long long PARALLEL_TERMS = 512;
+
+// Integer sums of the Chudnovsky series over the terms [a, b)
+struct Series {
+    LongNum p = 0LL;
+    LongNum q = 0LL;
+    LongNum t = 0LL;
+};
+
+Series binarySplit(long long a, long long b) {
+    if (b - a == 1) {
+        if (a == 0) {
+            return {1LL, 1LL, 13591409LL};
+        }
+        // Integer factors are multiplied as machine words while they fit
+        LongNum p = expr::lazy(6 * a - 5) * (2 * a - 1) * (6 * a - 1);
+        LongNum q = expr::lazy(a) * a * a * C3_OVER_24;
+        LongNum t = expr::lazy(p) * (13591409 + 545140134 * a);
+        return {p, q, a & 1 ? -t : t};
+    }
+    const long long m = (a + b) / 2;
+    if (b - a < PARALLEL_TERMS || parallel::threads() == 1) {
+        const Series left = binarySplit(a, m);
+        const Series right = binarySplit(m, b);
+        return {left.p * right.p, left.q * right.q, expr::lazy(right.q) * left.t + expr::lazy(left.p) * right.t};
+    }
+    Series left, right, result;
+    parallel::invoke([&] { left = binarySplit(a, m); }, [&] { right = binarySplit(m, b); });
+    LongNum leftT = 0LL;
+    parallel::invoke([&] { result.p = left.p * right.p; },
+                     [&] { result.q = left.q * right.q; },
+                     [&] { leftT = right.q * left.t; },
+                     [&] { result.t = left.p * right.t; });
+    result.t += leftT;
+    return result;
+}
+
+LongNum calculate_pi(const uint32_t precision) {
+    // https://www.craig-wood.com/nick/articles/pi-chudnovsky/
+    // Every term adds log2(C^3 / 24 / 72) ~ 47.11 bits
+    const double bitsPerTerm = std::log2(static_cast<double>(C3_OVER_24) / 72);
+    const long long terms = static_cast<long long>(precision / bitsPerTerm) + 2;
+    Series series;
+    LongNum sqrtC = 0LL;
+    parallel::invoke([&] { series = binarySplit(0, terms); },
+                     [&] { sqrtC = LongNum(10005LL).withPrecision(precision).sqrt(); });
+    LongNum pi = (426880 * sqrtC * series.q) / series.t;
+    return pi;
+}
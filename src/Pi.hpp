@@ -0,0 +1,9 @@
+#ifndef PI_H
+#define PI_H
+#include "LongNum.hpp"
+#include <cstdint>
+
+// Pi to `precision` binary places by the Chudnovsky series, summed by binary splitting
+LongNum calculate_pi(uint32_t precision);
+
+#endif
@@ -0,0 +1,283 @@
+#include "Limbs.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Conversion between limb arrays and decimal or hexadecimal strings. Large integers are split
+// recursively by precomputed powers 10^(9 * 2^k); pieces below LEAF_LIMBS are printed by repeated
+// division by 10^9. Binary fractions are multiplied by 10^count and printed the same way, small
+// ones are multiplied by 10^9 chunk by chunk. Parsing mirrors this: halves of the digit string
+// are combined as high * 10^(9 * 2^k) + low, short pieces are accumulated 9 digits at a time.
+
+namespace {
+
+using Limbs = limbs::Buffer;
+
+using limbs::significantSize;
+
+constexpr uint32_t CHUNK = 1000000000;
+constexpr size_t CHUNK_DIGITS = 9;
+constexpr size_t LEAF_LIMBS = 40;
+constexpr size_t LEAF_DIGITS = LEAF_LIMBS * CHUNK_DIGITS;
+// Halves of at least this many limbs are converted concurrently
+constexpr size_t PARALLEL_LIMBS = 2000;
+
+void appendPadded(std::string& out, uint32_t value, size_t width) {
+    const std::string digits = std::to_string(value);
+    out.append(width - digits.size(), '0');
+    out += digits;
+}
+
+Limbs product(const Limbs& a, const Limbs& b) {
+    Limbs result(a.size() + b.size());
+    limbs::mul(result.data(), a.data(), a.size(), b.data(), b.size());
+    result.resize(significantSize(result.data(), result.size()));
+    return result;
+}
+
+uint32_t parseChunk(std::string_view digits) {
+    uint32_t value = 0;
+    for (char c : digits) {
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+// powers[k] = 10^(9 * 2^k) while it has at most (n + 1) / 2 limbs
+std::vector<Limbs> decimalPowers(size_t n) {
+    std::vector<Limbs> powers = {{CHUNK}};
+    while (true) {
+        Limbs next = product(powers.back(), powers.back());
+        if (2 * next.size() - 1 > n) {
+            break;
+        }
+        powers.push_back(std::move(next));
+    }
+    return powers;
+}
+
+void convertLeaf(std::string& out, Limbs x, size_t width) {
+    Limbs chunks;
+    size_t n = significantSize(x.data(), x.size());
+    while (n) {
+        uint64_t rem = 0;
+        for (size_t i = n; i-- > 0;) {
+            const uint64_t cur = (rem << 32) | x[i];
+            x[i] = static_cast<uint32_t>(cur / CHUNK);
+            rem = cur % CHUNK;
+        }
+        chunks.push_back(static_cast<uint32_t>(rem));
+        n = significantSize(x.data(), n);
+    }
+    std::string digits;
+    for (size_t i = chunks.size(); i-- > 0;) {
+        if (i + 1 == chunks.size()) {
+            digits += std::to_string(chunks[i]);
+        } else {
+            appendPadded(digits, chunks[i], CHUNK_DIGITS);
+        }
+    }
+    if (digits.size() < width) {
+        out.append(width - digits.size(), '0');
+    }
+    out += digits;
+}
+
+// powers[k] divides by 10^(9 * 2^k), each level reuses the reciprocal of its power
+void convert(std::string& out, const uint32_t* x, size_t n, size_t width, const std::vector<limbs::Divisor>& powers) {
+    n = significantSize(x, n);
+    size_t k = powers.size();
+    while (k > 0 && 2 * powers[k - 1].size() - 1 > n) {
+        k--;
+    }
+    if (n <= LEAF_LIMBS || k == 0) {
+        convertLeaf(out, Limbs(x, x + n), width);
+        return;
+    }
+    const limbs::Divisor& divisor = powers[k - 1];
+    const size_t lowWidth = CHUNK_DIGITS << (k - 1);
+    Limbs q(n - divisor.size() + 1), r(divisor.size());
+    divisor.divRem(q.data(), r.data(), x, n);
+    const size_t highWidth = width > lowWidth ? width - lowWidth : 0;
+    if (n >= PARALLEL_LIMBS && parallel::threads() > 1) {
+        std::string low;
+        parallel::invoke([&] { convert(out, q.data(), q.size(), highWidth, powers); },
+                         [&] { convert(low, r.data(), r.size(), lowWidth, powers); });
+        out += low;
+        return;
+    }
+    convert(out, q.data(), q.size(), highWidth, powers);
+    convert(out, r.data(), r.size(), lowWidth, powers);
+}
+
+Limbs parseLeaf(std::string_view digits) {
+    Limbs x;
+    size_t first = digits.size() % CHUNK_DIGITS;
+    if (first == 0) {
+        first = CHUNK_DIGITS;
+    }
+    for (size_t pos = 0; pos < digits.size(); pos += pos ? CHUNK_DIGITS : first) {
+        const size_t len = pos ? CHUNK_DIGITS : first;
+        uint32_t carry = limbs::mul1(x.data(), x.data(), x.size(), pos ? CHUNK : 1);
+        if (carry) {
+            x.push_back(carry);
+        }
+        const uint32_t chunk = parseChunk(digits.substr(pos, len));
+        x.push_back(0);
+        limbs::addInto(x.data(), x.size(), &chunk, 1);
+        x.resize(significantSize(x.data(), x.size()));
+    }
+    return x;
+}
+
+// powers[k] = 10^(9 * 2^k) is used to split strings longer than 9 * 2^k digits
+Limbs parse(std::string_view digits, const std::vector<Limbs>& powers) {
+    size_t k = powers.size();
+    while (k > 0 && (CHUNK_DIGITS << (k - 1)) >= digits.size()) {
+        k--;
+    }
+    if (digits.size() <= LEAF_DIGITS || k == 0) {
+        return parseLeaf(digits);
+    }
+    const size_t lowLength = CHUNK_DIGITS << (k - 1);
+    const Limbs high = parse(digits.substr(0, digits.size() - lowLength), powers);
+    const Limbs low = parse(digits.substr(digits.size() - lowLength), powers);
+    if (high.empty()) {
+        return low;
+    }
+    Limbs result = product(high, powers[k - 1]);
+    result.push_back(0);
+    limbs::addInto(result.data(), result.size(), low.data(), low.size());
+    result.resize(significantSize(result.data(), result.size()));
+    return result;
+}
+
+uint32_t hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    return (c | 0x20) - 'a' + 10;
+}
+
+// 10^count as limbs
+Limbs decimalPower(size_t count) {
+    Limbs result = {1}, base = {10};
+    while (count) {
+        if (count & 1) {
+            result = product(result, base);
+        }
+        count >>= 1;
+        if (count) {
+            base = product(base, base);
+        }
+    }
+    return result;
+}
+
+}
+
+std::string limbs::toDecimal(const uint32_t* x, size_t n, size_t width) {
+    n = significantSize(x, n);
+    std::string out;
+    if (n == 0) {
+        out.assign(std::max<size_t>(width, 1), '0');
+        return out;
+    }
+    std::vector<limbs::Divisor> divisors;
+    if (n > LEAF_LIMBS) {
+        for (const Limbs& power : decimalPowers(n)) {
+            divisors.emplace_back(power.data(), power.size());
+        }
+    }
+    convert(out, x, n, width, divisors);
+    return out;
+}
+
+std::string limbs::fractionToDecimal(const uint32_t* f, size_t n, size_t count) {
+    // n binary limbs never need more than 32 * n decimal places
+    count = std::min(count, 32 * n);
+    std::string out;
+    if (n <= LEAF_LIMBS || count <= CHUNK_DIGITS) {
+        Limbs x(f, f + n);
+        size_t len = significantSize(x.data(), n);
+        while (len && out.size() < count) {
+            const size_t digits = std::min(CHUNK_DIGITS, count - out.size());
+            uint32_t factor = 1;
+            for (size_t i = 0; i < digits; i++) {
+                factor *= 10;
+            }
+            appendPadded(out, limbs::mul1(x.data(), x.data(), n, factor), digits);
+            len = significantSize(x.data(), n);
+        }
+        if (len == 0) {
+            out.erase(out.find_last_not_of('0') + 1);
+        }
+        return out;
+    }
+    // floor(f * 10^count / B^n) holds the first `count` digits
+    const Limbs power = decimalPower(count);
+    Limbs scaled(n + power.size());
+    limbs::mul(scaled.data(), f, n, power.data(), power.size());
+    out = toDecimal(scaled.data() + n, power.size(), count);
+    if (significantSize(scaled.data(), n) == 0) {
+        out.erase(out.find_last_not_of('0') + 1);
+    }
+    return out;
+}
+
+limbs::Buffer limbs::fromDecimal(std::string_view digits) {
+    std::vector<Limbs> powers = {{CHUNK}};
+    while ((CHUNK_DIGITS << powers.size()) < digits.size() && digits.size() > LEAF_DIGITS) {
+        powers.push_back(product(powers.back(), powers.back()));
+    }
+    return parse(digits, powers);
+}
+
+limbs::Buffer limbs::fractionFromDecimal(std::string_view digits, size_t n) {
+    digits = digits.substr(0, digits.find_last_not_of('0') + 1);
+    Limbs result(n + 1, 0);
+    if (digits.empty()) {
+        return result;
+    }
+    // floor((2 * digits * B^n + 10^count) / (2 * 10^count)) rounds to the nearest
+    const Limbs value = fromDecimal(digits);
+    const Limbs power = decimalPower(digits.size());
+    Limbs num(n, 0);
+    num.insert(num.end(), value.begin(), value.end());
+    num.push_back(limbs::mul1(num.data(), num.data(), num.size(), 2));
+    num.push_back(0);
+    limbs::addInto(num.data(), num.size(), power.data(), power.size());
+    Limbs den = power;
+    den.push_back(limbs::mul1(den.data(), den.data(), den.size(), 2));
+    num.resize(significantSize(num.data(), num.size()));
+    den.resize(significantSize(den.data(), den.size()));
+
+    if (num.size() >= den.size()) {
+        Limbs q(num.size() - den.size() + 1);
+        limbs::divRem(q.data(), nullptr, num.data(), num.size(), den.data(), den.size());
+        std::copy(q.begin(), q.begin() + std::min(n + 1, q.size()), result.begin());
+    }
+    return result;
+}
+
+limbs::Buffer limbs::fromHex(std::string_view digits) {
+    Limbs result((digits.size() + 7) / 8, 0);
+    for (size_t i = 0; i < digits.size(); i++) {
+        const size_t bit = 4 * (digits.size() - 1 - i);
+        result[bit / 32] |= hexValue(digits[i]) << (bit % 32);
+    }
+    result.resize(significantSize(result.data(), result.size()));
+    return result;
+}
+
+limbs::Buffer limbs::fractionFromHex(std::string_view digits, size_t n) {
+    Limbs result(n + 1, 0);
+    for (size_t i = 0; i < digits.size() && i < 8 * n; i++) {
+        const size_t bit = 32 * n - 4 * (i + 1);
+        result[bit / 32] |= hexValue(digits[i]) << (bit % 32);
+    }
+    return result;
+}
@@ -0,0 +1,297 @@
+#include "LongNum.hpp"
+#include "LongNumView.hpp"
+#include "Limbs.hpp"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary format of LongNum::write, version 1. All fields are little-endian:
+//
+//     offset  size
+//          0     4  "LNUM"
+//          4     2  format version
+//          6     2  flags: bit 0 is the sign, the others are zero
+//          8     4  precision in binary places
+//         12     4  zero
+//         16     8  limb count n, at least the fractional limbs; the top limb is not zero when
+//                   there are more
+//         24    4n  limbs, least significant first
+//     24 + 4n     8  checksum of the header and the limbs
+//
+// The limbs start at a multiple of 8 bytes, so a mapped file can be used in place. The checksum
+// keeps two sums modulo 2^64 of the 32-bit words, the second one of the running values of the
+// first, as in Fletcher's checksum.
+
+namespace {
+
+constexpr char MAGIC[4] = {'L', 'N', 'U', 'M'};
+constexpr uint16_t VERSION = 1;
+constexpr uint16_t NEGATIVE = 1;
+constexpr size_t HEADER_BYTES = 24;
+constexpr size_t CHECKSUM_BYTES = 8;
+// Limbs converted or read at a time
+constexpr size_t CHUNK = 1 << 16;
+
+constexpr bool LITTLE_ENDIAN_HOST = std::endian::native == std::endian::little;
+
+template <typename T>
+void storeLittle(unsigned char* p, T value) {
+    for (size_t i = 0; i < sizeof(T); i++) {
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+template <typename T>
+T loadLittle(const unsigned char* p) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        value |= static_cast<T>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+struct Header {
+    bool negative;
+    uint32_t precision;
+    uint64_t count;
+};
+
+class Checksum {
+public:
+    void add(const uint32_t* words, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            a += words[i];
+            b += a;
+        }
+    }
+
+    void addHeader(const unsigned char* header) {
+        uint32_t words[HEADER_BYTES / 4];
+        for (size_t i = 0; i < HEADER_BYTES / 4; i++) {
+            words[i] = loadLittle<uint32_t>(header + 4 * i);
+        }
+        add(words, HEADER_BYTES / 4);
+    }
+
+    uint64_t value(void) const {
+        return a ^ std::rotl(b, 32);
+    }
+
+private:
+    uint64_t a = 0;
+    uint64_t b = 0;
+};
+
+void encodeHeader(unsigned char* out, const Header& header) {
+    std::memcpy(out, MAGIC, sizeof(MAGIC));
+    storeLittle<uint16_t>(out + 4, VERSION);
+    storeLittle<uint16_t>(out + 6, header.negative ? NEGATIVE : 0);
+    storeLittle<uint32_t>(out + 8, header.precision);
+    storeLittle<uint32_t>(out + 12, 0);
+    storeLittle<uint64_t>(out + 16, header.count);
+}
+
+Header decodeHeader(const unsigned char* in) {
+    if (std::memcmp(in, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::invalid_argument("Wrong binary format: not a LongNum");
+    }
+    if (loadLittle<uint16_t>(in + 4) != VERSION) {
+        throw std::invalid_argument("Wrong binary format: unsupported version " +
+                                    std::to_string(loadLittle<uint16_t>(in + 4)));
+    }
+    const uint16_t flags = loadLittle<uint16_t>(in + 6);
+    if ((flags & ~NEGATIVE) != 0 || loadLittle<uint32_t>(in + 12) != 0) {
+        throw std::invalid_argument("Wrong binary format: unknown flags");
+    }
+    const Header header = {(flags & NEGATIVE) != 0, loadLittle<uint32_t>(in + 8), loadLittle<uint64_t>(in + 16)};
+    // LongNum keeps the precision in an int
+    if (header.precision > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+        throw std::invalid_argument("Wrong binary format: precision out of range");
+    }
+    if (header.count < header.precision / 32 + (header.precision % 32 != 0)) {
+        throw std::invalid_argument("Wrong binary format: fewer limbs than the precision needs");
+    }
+    return header;
+}
+
+// The top limb of a number with integer limbs is not zero, as LongNum keeps it
+void checkNormalized(const Header& header, const uint32_t* limbs) {
+    const uint64_t fractionDigits = header.precision / 32 + (header.precision % 32 != 0);
+    if (header.count > fractionDigits && limbs[header.count - 1] == 0) {
+        throw std::invalid_argument("Wrong binary format: leading zero limbs");
+    }
+}
+
+// Limbs in the byte order of the host, converted in place
+void fromLittle(uint32_t* limbs, size_t n) {
+    if constexpr (!LITTLE_ENDIAN_HOST) {
+        for (size_t i = 0; i < n; i++) {
+            limbs[i] = std::byteswap(limbs[i]);
+        }
+    }
+}
+
+}
+
+// ****** LongNum ******
+
+void LongNum::write(std::ostream& out) const {
+    const size_t fractionDigits = precision / 32 + (precision % 32 != 0);
+    const size_t count = std::max<size_t>(fractionDigits, limbs::significantSize(digits.data(), digits.size()));
+    unsigned char header[HEADER_BYTES];
+    encodeHeader(header, {isNegative, static_cast<uint32_t>(precision), count});
+    out.write(reinterpret_cast<const char*>(header), HEADER_BYTES);
+
+    Checksum checksum;
+    checksum.addHeader(header);
+    checksum.add(digits.data(), count);
+    if constexpr (LITTLE_ENDIAN_HOST) {
+        out.write(reinterpret_cast<const char*>(digits.data()), static_cast<std::streamsize>(count * 4));
+    } else {
+        std::vector<uint32_t> chunk;
+        for (size_t i = 0; i < count; i += CHUNK) {
+            chunk.assign(digits.data() + i, digits.data() + std::min(count, i + CHUNK));
+            for (uint32_t& limb : chunk) {
+                limb = std::byteswap(limb);
+            }
+            out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size() * 4));
+        }
+    }
+    unsigned char trailer[CHECKSUM_BYTES];
+    storeLittle<uint64_t>(trailer, checksum.value());
+    out.write(reinterpret_cast<const char*>(trailer), CHECKSUM_BYTES);
+}
+
+LongNum LongNum::read(std::istream& in) {
+    unsigned char header[HEADER_BYTES];
+    if (!in.read(reinterpret_cast<char*>(header), HEADER_BYTES)) {
+        throw std::invalid_argument("Wrong binary format: truncated header");
+    }
+    const Header fields = decodeHeader(header);
+
+    LongNum result = 0LL;
+    result.precision = static_cast<int>(fields.precision);
+    // The limbs arrive in chunks, a corrupted count does not allocate more than the data holds
+    for (uint64_t done = 0; done < fields.count;) {
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(CHUNK, fields.count - done));
+        result.digits.resize_for_overwrite(done + n);
+        if (!in.read(reinterpret_cast<char*>(result.digits.data() + done), static_cast<std::streamsize>(n * 4))) {
+            throw std::invalid_argument("Wrong binary format: truncated limbs");
+        }
+        fromLittle(result.digits.data() + done, n);
+        done += n;
+    }
+    unsigned char trailer[CHECKSUM_BYTES];
+    if (!in.read(reinterpret_cast<char*>(trailer), CHECKSUM_BYTES)) {
+        throw std::invalid_argument("Wrong binary format: truncated checksum");
+    }
+    Checksum checksum;
+    checksum.addHeader(header);
+    checksum.add(result.digits.data(), result.digits.size());
+    if (checksum.value() != loadLittle<uint64_t>(trailer)) {
+        throw std::invalid_argument("Wrong binary format: checksum mismatch");
+    }
+    checkNormalized(fields, result.digits.data());
+    result.isNegative = fields.negative;
+    return result;
+}
+
+// ****** LongNumView ******
+
+LongNumView::LongNumView(const std::string& path) {
+    if constexpr (!LITTLE_ENDIAN_HOST) {
+        throw std::invalid_argument("LongNumView needs a little-endian platform");
+    }
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot stat " + path);
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length < HEADER_BYTES + CHECKSUM_BYTES) {
+        ::close(fd);
+        throw std::invalid_argument("Wrong binary format: truncated header");
+    }
+    mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::system_error(error, std::generic_category(), "Cannot map " + path);
+    }
+
+    try {
+        const auto* bytes = static_cast<const unsigned char*>(mapping);
+        const Header header = decodeHeader(bytes);
+        if (header.count != (length - HEADER_BYTES - CHECKSUM_BYTES) / 4 ||
+            (length - HEADER_BYTES - CHECKSUM_BYTES) % 4 != 0) {
+            throw std::invalid_argument("Wrong binary format: the size of the file does not match the limb count");
+        }
+        const auto* limbs = reinterpret_cast<const uint32_t*>(bytes + HEADER_BYTES);
+        checkNormalized(header, limbs);
+        number.digits = LimbVector::borrow(limbs, header.count);
+        number.precision = static_cast<int>(header.precision);
+        number.isNegative = header.negative;
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+LongNumView::LongNumView(LongNumView&& other) noexcept
+    : mapping(std::exchange(other.mapping, nullptr)), length(std::exchange(other.length, 0)),
+      number(std::move(other.number)) {
+}
+
+LongNumView& LongNumView::operator=(LongNumView&& other) noexcept {
+    if (this != &other) {
+        number = std::move(other.number);
+        unmap();
+        mapping = std::exchange(other.mapping, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+LongNumView::~LongNumView() {
+    number = 0LL;
+    unmap();
+}
+
+bool LongNumView::verify(void) const {
+    const auto* bytes = static_cast<const unsigned char*>(mapping);
+    if (!bytes) {
+        return false;
+    }
+    Checksum checksum;
+    checksum.addHeader(bytes);
+    checksum.add(reinterpret_cast<const uint32_t*>(bytes + HEADER_BYTES), (length - HEADER_BYTES - CHECKSUM_BYTES) / 4);
+    return checksum.value() == loadLittle<uint64_t>(bytes + length - CHECKSUM_BYTES);
+}
+
+void LongNumView::unmap(void) {
+    if (mapping) {
+        ::munmap(mapping, length);
+        mapping = nullptr;
+        length = 0;
+    }
+}
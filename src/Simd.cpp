@@ -0,0 +1,315 @@
+#include "Limbs.hpp"
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if LONGNUM_SIMD
+#include <immintrin.h>
+
+// Vector versions of the scanning and shifting primitives. A set of kernels is chosen on first
+// use from the features reported by CPUID: AVX-512, AVX2 or SSE2 (always present on x86-64).
+// The environment variable LONGNUM_SIMD=avx512|avx2|sse2|scalar selects a set by hand, a set the
+// CPU does not support is ignored. Loads are unaligned, the operands are often offsets into a
+// buffer, but the buffers themselves start on a cache line so the loads rarely straddle two.
+
+namespace {
+
+// ****** Scalar ******
+
+uint32_t lshiftScalar(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    if (n == 0) {
+        return 0;
+    }
+    const uint32_t high = static_cast<uint32_t>((static_cast<uint64_t>(a[n - 1]) << bits) >> 32);
+    for (size_t i = n - 1; i > 0; i--) {
+        out[i] = (a[i] << bits) | static_cast<uint32_t>((static_cast<uint64_t>(a[i - 1]) << bits) >> 32);
+    }
+    out[0] = a[0] << bits;
+    return high;
+}
+
+// Without the bits shifted out, which the callers compute before overwriting a
+void rshiftScalar(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    for (size_t i = 0; i + 1 < n; i++) {
+        out[i] = (a[i] >> bits) | static_cast<uint32_t>(static_cast<uint64_t>(a[i + 1]) << (32 - bits));
+    }
+    if (n) {
+        out[n - 1] = a[n - 1] >> bits;
+    }
+}
+
+uint32_t rshiftScalarKernel(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    const uint32_t low = n ? static_cast<uint32_t>(static_cast<uint64_t>(a[0]) << (32 - bits)) : 0;
+    rshiftScalar(out, a, n, bits);
+    return low;
+}
+
+int cmpScalar(const uint32_t* a, const uint32_t* b, size_t n) {
+    for (size_t i = n; i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+size_t significantSizeScalar(const uint32_t* x, size_t n) {
+    while (n && x[n - 1] == 0) {
+        n--;
+    }
+    return n;
+}
+
+// Result of a block compare: `mask` has a bit set for every differing limb of the block at `i`
+int differingLimb(const uint32_t* a, const uint32_t* b, size_t i, uint32_t mask) {
+    const size_t index = i + 31 - std::countl_zero(mask);
+    return a[index] < b[index] ? -1 : 1;
+}
+
+// ****** SSE2 ******
+
+uint32_t lshiftSse2(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    if (n == 0) {
+        return 0;
+    }
+    const uint32_t high = static_cast<uint32_t>((static_cast<uint64_t>(a[n - 1]) << bits) >> 32);
+    const __m128i left = _mm_cvtsi32_si128(bits), right = _mm_cvtsi32_si128(32 - bits);
+    size_t i = n;
+    while (i >= 5) {
+        i -= 4;
+        const __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i - 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(_mm_sll_epi32(cur, left), _mm_srl_epi32(prev, right)));
+    }
+    lshiftScalar(out, a, i, bits);
+    return high;
+}
+
+uint32_t rshiftSse2(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    const uint32_t low = n ? static_cast<uint32_t>(static_cast<uint64_t>(a[0]) << (32 - bits)) : 0;
+    const __m128i right = _mm_cvtsi32_si128(bits), left = _mm_cvtsi32_si128(32 - bits);
+    size_t i = 0;
+    for (; i + 4 < n; i += 4) {
+        const __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_or_si128(_mm_srl_epi32(cur, right), _mm_sll_epi32(next, left)));
+    }
+    rshiftScalar(out + i, a + i, n - i, bits);
+    return low;
+}
+
+int cmpSse2(const uint32_t* a, const uint32_t* b, size_t n) {
+    size_t i = n;
+    while (i >= 4) {
+        i -= 4;
+        const __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+        const uint32_t mask = ~_mm_movemask_ps(_mm_castsi128_ps(equal)) & 0xf;
+        if (mask) {
+            return differingLimb(a, b, i, mask);
+        }
+    }
+    return cmpScalar(a, b, i);
+}
+
+size_t significantSizeSse2(const uint32_t* x, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    while (n >= 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + n - 4));
+        const uint32_t mask = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, zero))) & 0xf;
+        if (mask) {
+            return n - 4 + 32 - std::countl_zero(mask);
+        }
+        n -= 4;
+    }
+    return significantSizeScalar(x, n);
+}
+
+// ****** AVX2 ******
+
+__attribute__((target("avx2"))) uint32_t lshiftAvx2(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    if (n == 0) {
+        return 0;
+    }
+    const uint32_t high = static_cast<uint32_t>((static_cast<uint64_t>(a[n - 1]) << bits) >> 32);
+    const __m128i left = _mm_cvtsi32_si128(bits), right = _mm_cvtsi32_si128(32 - bits);
+    size_t i = n;
+    while (i >= 9) {
+        i -= 8;
+        const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i - 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_or_si256(_mm256_sll_epi32(cur, left), _mm256_srl_epi32(prev, right)));
+    }
+    lshiftScalar(out, a, i, bits);
+    return high;
+}
+
+__attribute__((target("avx2"))) uint32_t rshiftAvx2(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    const uint32_t low = n ? static_cast<uint32_t>(static_cast<uint64_t>(a[0]) << (32 - bits)) : 0;
+    const __m128i right = _mm_cvtsi32_si128(bits), left = _mm_cvtsi32_si128(32 - bits);
+    size_t i = 0;
+    for (; i + 8 < n; i += 8) {
+        const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_or_si256(_mm256_srl_epi32(cur, right), _mm256_sll_epi32(next, left)));
+    }
+    rshiftScalar(out + i, a + i, n - i, bits);
+    return low;
+}
+
+__attribute__((target("avx2"))) int cmpAvx2(const uint32_t* a, const uint32_t* b, size_t n) {
+    size_t i = n;
+    while (i >= 8) {
+        i -= 8;
+        const __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        const uint32_t mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(equal)) & 0xff;
+        if (mask) {
+            return differingLimb(a, b, i, mask);
+        }
+    }
+    return cmpScalar(a, b, i);
+}
+
+__attribute__((target("avx2"))) size_t significantSizeAvx2(const uint32_t* x, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    while (n >= 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + n - 8));
+        const uint32_t mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, zero))) & 0xff;
+        if (mask) {
+            return n - 8 + 32 - std::countl_zero(mask);
+        }
+        n -= 8;
+    }
+    return significantSizeScalar(x, n);
+}
+
+// ****** AVX-512 ******
+
+// The shifts take per-lane counts, where a count of 32 gives 0 like the scalar code. They use
+// the zero-masked forms with all lanes set: the unmasked ones pass an undefined vector that
+// GCC 12 reports as maybe uninitialized
+
+__attribute__((target("avx512f"))) uint32_t lshiftAvx512(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    if (n == 0) {
+        return 0;
+    }
+    const uint32_t high = static_cast<uint32_t>((static_cast<uint64_t>(a[n - 1]) << bits) >> 32);
+    const __m512i left = _mm512_set1_epi32(bits), right = _mm512_set1_epi32(32 - bits);
+    size_t i = n;
+    while (i >= 17) {
+        i -= 16;
+        const __m512i cur = _mm512_loadu_si512(a + i);
+        const __m512i prev = _mm512_loadu_si512(a + i - 1);
+        _mm512_storeu_si512(out + i, _mm512_or_si512(_mm512_maskz_sllv_epi32(0xFFFF, cur, left),
+                                                     _mm512_maskz_srlv_epi32(0xFFFF, prev, right)));
+    }
+    lshiftScalar(out, a, i, bits);
+    return high;
+}
+
+__attribute__((target("avx512f"))) uint32_t rshiftAvx512(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    const uint32_t low = n ? static_cast<uint32_t>(static_cast<uint64_t>(a[0]) << (32 - bits)) : 0;
+    const __m512i right = _mm512_set1_epi32(bits), left = _mm512_set1_epi32(32 - bits);
+    size_t i = 0;
+    for (; i + 16 < n; i += 16) {
+        const __m512i cur = _mm512_loadu_si512(a + i);
+        const __m512i next = _mm512_loadu_si512(a + i + 1);
+        _mm512_storeu_si512(out + i, _mm512_or_si512(_mm512_maskz_srlv_epi32(0xFFFF, cur, right),
+                                                     _mm512_maskz_sllv_epi32(0xFFFF, next, left)));
+    }
+    rshiftScalar(out + i, a + i, n - i, bits);
+    return low;
+}
+
+__attribute__((target("avx512f"))) int cmpAvx512(const uint32_t* a, const uint32_t* b, size_t n) {
+    size_t i = n;
+    while (i >= 16) {
+        i -= 16;
+        const uint32_t mask = _mm512_cmpneq_epi32_mask(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+        if (mask) {
+            return differingLimb(a, b, i, mask);
+        }
+    }
+    return cmpScalar(a, b, i);
+}
+
+__attribute__((target("avx512f"))) size_t significantSizeAvx512(const uint32_t* x, size_t n) {
+    while (n >= 16) {
+        const __m512i v = _mm512_loadu_si512(x + n - 16);
+        const uint32_t mask = _mm512_test_epi32_mask(v, v);
+        if (mask) {
+            return n - 16 + 32 - std::countl_zero(mask);
+        }
+        n -= 16;
+    }
+    return significantSizeScalar(x, n);
+}
+
+// ****** Dispatch ******
+
+struct Kernels {
+    const char* name;
+    uint32_t (*lshift)(uint32_t*, const uint32_t*, size_t, unsigned);
+    uint32_t (*rshift)(uint32_t*, const uint32_t*, size_t, unsigned);
+    int (*cmp)(const uint32_t*, const uint32_t*, size_t);
+    size_t (*significantSize)(const uint32_t*, size_t);
+};
+
+constexpr Kernels SCALAR = {"scalar", lshiftScalar, rshiftScalarKernel, cmpScalar, significantSizeScalar};
+constexpr Kernels SSE2 = {"sse2", lshiftSse2, rshiftSse2, cmpSse2, significantSizeSse2};
+constexpr Kernels AVX2 = {"avx2", lshiftAvx2, rshiftAvx2, cmpAvx2, significantSizeAvx2};
+constexpr Kernels AVX512 = {"avx512", lshiftAvx512, rshiftAvx512, cmpAvx512, significantSizeAvx512};
+
+Kernels select(void) {
+    __builtin_cpu_init();
+    const bool avx512 = __builtin_cpu_supports("avx512f");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+    if (const char* forced = std::getenv("LONGNUM_SIMD")) {
+        if (std::strcmp(forced, "scalar") == 0) {
+            return SCALAR;
+        }
+        if (std::strcmp(forced, "sse2") == 0) {
+            return SSE2;
+        }
+        if (std::strcmp(forced, "avx2") == 0 && avx2) {
+            return AVX2;
+        }
+        if (std::strcmp(forced, "avx512") == 0 && avx512) {
+            return AVX512;
+        }
+    }
+    return avx512 ? AVX512 : avx2 ? AVX2 : SSE2;
+}
+
+const Kernels& kernels(void) {
+    static const Kernels selected = select();
+    return selected;
+}
+
+}
+
+uint32_t limbs::simd::lshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    return kernels().lshift(out, a, n, bits);
+}
+
+uint32_t limbs::simd::rshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+    return kernels().rshift(out, a, n, bits);
+}
+
+int limbs::simd::cmp(const uint32_t* a, const uint32_t* b, size_t n) {
+    return kernels().cmp(a, b, n);
+}
+
+size_t limbs::simd::significantSize(const uint32_t* x, size_t n) {
+    return kernels().significantSize(x, n);
+}
+
+const char* limbs::simd::name(void) {
+    return kernels().name;
+}
+
+#endif
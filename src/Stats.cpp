@@ -0,0 +1,113 @@
+#include "Stats.hpp"
+#include <iomanip>
+#include <iterator>
+#include <ostream>
+
+#if LONGNUM_STATS
+stats::AtomicCounter stats::operationCounters[stats::OPERATIONS];
+stats::AtomicCounter stats::tierCounters[stats::TIERS];
+std::atomic<uint64_t> stats::allocations = 0;
+std::atomic<uint64_t> stats::allocatedBytes = 0;
+std::atomic<uint64_t> stats::currentBytes = 0;
+std::atomic<uint64_t> stats::peakBytes = 0;
+#endif
+
+namespace {
+
+constexpr const char* OPERATION_NAMES[] = {"add", "subtract", "multiply", "divide", "shift", "compare",
+                                           "pow", "sqrt", "toString", "parse"};
+constexpr const char* TIER_NAMES[] = {"schoolbook", "karatsuba", "toom3", "toom4", "ntt", "blocked",
+                                      "long division", "newton division"};
+
+static_assert(std::size(OPERATION_NAMES) == stats::OPERATIONS);
+static_assert(std::size(TIER_NAMES) == stats::TIERS);
+
+#if LONGNUM_STATS
+stats::Counter load(const stats::AtomicCounter& counter) {
+    return {counter.calls.load(std::memory_order_relaxed), counter.limbs.load(std::memory_order_relaxed),
+            counter.nanoseconds.load(std::memory_order_relaxed)};
+}
+
+void clear(stats::AtomicCounter& counter) {
+    counter.calls.store(0, std::memory_order_relaxed);
+    counter.limbs.store(0, std::memory_order_relaxed);
+    counter.nanoseconds.store(0, std::memory_order_relaxed);
+}
+#endif
+
+void printRow(std::ostream& out, const char* name, const stats::Counter& counter) {
+    out << std::setw(16) << name << std::setw(14) << counter.calls << std::setw(16) << counter.limbs
+        << std::setw(12) << std::fixed << std::setprecision(3) << counter.nanoseconds / 1e9 << '\n';
+}
+
+double megabytes(uint64_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+}
+
+const char* stats::name(Operation operation) {
+    return OPERATION_NAMES[static_cast<size_t>(operation)];
+}
+
+const char* stats::name(Tier tier) {
+    return TIER_NAMES[static_cast<size_t>(tier)];
+}
+
+stats::Snapshot stats::snapshot(void) {
+    Snapshot result;
+#if LONGNUM_STATS
+    for (size_t i = 0; i < OPERATIONS; i++) {
+        result.operations[i] = load(operationCounters[i]);
+    }
+    for (size_t i = 0; i < TIERS; i++) {
+        result.tiers[i] = load(tierCounters[i]);
+    }
+    result.allocations = allocations.load(std::memory_order_relaxed);
+    result.allocatedBytes = allocatedBytes.load(std::memory_order_relaxed);
+    result.currentBytes = currentBytes.load(std::memory_order_relaxed);
+    result.peakBytes = peakBytes.load(std::memory_order_relaxed);
+#endif
+    return result;
+}
+
+void stats::reset(void) {
+#if LONGNUM_STATS
+    for (AtomicCounter& counter : operationCounters) {
+        clear(counter);
+    }
+    for (AtomicCounter& counter : tierCounters) {
+        clear(counter);
+    }
+    allocations.store(0, std::memory_order_relaxed);
+    allocatedBytes.store(0, std::memory_order_relaxed);
+    peakBytes.store(currentBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+#endif
+}
+
+std::ostream& stats::operator<<(std::ostream& out, const Snapshot& snapshot) {
+    if (!snapshot.enabled) {
+        return out << "Statistics are not collected, build with -DLONGNUM_STATS=1\n";
+    }
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::setw(16) << "operation" << std::setw(14) << "calls" << std::setw(16) << "limbs"
+        << std::setw(12) << "seconds" << '\n';
+    for (size_t i = 0; i < OPERATIONS; i++) {
+        if (snapshot.operations[i].calls) {
+            printRow(out, OPERATION_NAMES[i], snapshot.operations[i]);
+        }
+    }
+    out << std::setw(16) << "tier" << '\n';
+    for (size_t i = 0; i < TIERS; i++) {
+        if (snapshot.tiers[i].calls) {
+            printRow(out, TIER_NAMES[i], snapshot.tiers[i]);
+        }
+    }
+    out << std::setprecision(1) << "allocations: " << snapshot.allocations << " (" << megabytes(snapshot.allocatedBytes)
+        << " MiB), limb memory: " << megabytes(snapshot.currentBytes) << " MiB now, "
+        << megabytes(snapshot.peakBytes) << " MiB at peak\n";
+    out.flags(flags);
+    out.precision(precision);
+    return out;
+}
@@ -0,0 +1,137 @@
+#ifndef STATS_H
+#define STATS_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+// Instrumentation of the library: calls, operand limbs and wall time per operation and per algorithm
+// tier, and the limb buffers allocated. It is compiled in with -DLONGNUM_STATS=1 (make STATS=1);
+// otherwise the recording functions below are empty and snapshots are all zero
+#ifndef LONGNUM_STATS
+#define LONGNUM_STATS 0
+#endif
+
+#if LONGNUM_STATS
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace stats {
+
+    // Operations of LongNum, counted by the operator called whatever the signs of the operands.
+    // Adding or subtracting a built-in integer both count as add, comparisons are those of two
+    // numbers, and parsing counts 8 characters of the string as a limb
+    enum class Operation { Add, Subtract, Multiply, Divide, Shift, Compare, Pow, Sqrt, ToString, Parse, Count };
+
+    // Multiplication algorithms (at every level of their recursion, so the time of a tier includes
+    // the lower tiers it calls) including the block products of numbers in swap files, long division
+    // by one limb or by Knuth's algorithm, and division by a Newton reciprocal
+    enum class Tier { Schoolbook, Karatsuba, Toom3, Toom4, Ntt, Blocked, LongDivision, NewtonDivision, Count };
+
+    constexpr size_t OPERATIONS = static_cast<size_t>(Operation::Count);
+    constexpr size_t TIERS = static_cast<size_t>(Tier::Count);
+
+    const char* name(Operation operation);
+    const char* name(Tier tier);
+
+    struct Counter {
+        uint64_t calls = 0;
+        // Limbs of the operands, summed over the calls
+        uint64_t limbs = 0;
+        // Wall time including the operations called inside
+        uint64_t nanoseconds = 0;
+    };
+
+    struct Snapshot {
+        // Whether the library was built with the instrumentation
+        bool enabled = LONGNUM_STATS;
+        std::array<Counter, OPERATIONS> operations{};
+        std::array<Counter, TIERS> tiers{};
+        // Limb buffers of numbers and kernel temporaries allocated since the reset
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        // Bytes of the limb buffers alive at the snapshot, and the most alive at once since the reset
+        uint64_t currentBytes = 0;
+        uint64_t peakBytes = 0;
+
+        const Counter& operator[](Operation operation) const {
+            return operations[static_cast<size_t>(operation)];
+        }
+        const Counter& operator[](Tier tier) const {
+            return tiers[static_cast<size_t>(tier)];
+        }
+    };
+
+    // A table of the operations and tiers that were used, then the allocations
+    std::ostream& operator<<(std::ostream& out, const Snapshot& snapshot);
+
+    Snapshot snapshot(void);
+    // Zeroes the counters, the peak starts again from the memory alive now
+    void reset(void);
+
+#if LONGNUM_STATS
+    struct AtomicCounter {
+        std::atomic<uint64_t> calls = 0;
+        std::atomic<uint64_t> limbs = 0;
+        std::atomic<uint64_t> nanoseconds = 0;
+    };
+
+    extern AtomicCounter operationCounters[OPERATIONS];
+    extern AtomicCounter tierCounters[TIERS];
+    extern std::atomic<uint64_t> allocations;
+    extern std::atomic<uint64_t> allocatedBytes;
+    extern std::atomic<uint64_t> currentBytes;
+    extern std::atomic<uint64_t> peakBytes;
+
+    inline void allocated(size_t bytes) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        const uint64_t current = currentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+        while (current > peak && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+    }
+
+    inline void released(size_t bytes) {
+        currentBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    // Counts a call with operands of the given size and the time until the end of the scope
+    class Scope {
+    public:
+        Scope(Operation operation, size_t limbs) : Scope(operationCounters[static_cast<size_t>(operation)], limbs) {}
+        Scope(Tier tier, size_t limbs) : Scope(tierCounters[static_cast<size_t>(tier)], limbs) {}
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope() {
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            counter.nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                                          std::memory_order_relaxed);
+        }
+
+    private:
+        AtomicCounter& counter;
+        std::chrono::steady_clock::time_point start;
+
+        Scope(AtomicCounter& counter, size_t limbs) : counter(counter) {
+            counter.calls.fetch_add(1, std::memory_order_relaxed);
+            counter.limbs.fetch_add(limbs, std::memory_order_relaxed);
+            start = std::chrono::steady_clock::now();
+        }
+    };
+#else
+    inline void allocated(size_t) {}
+    inline void released(size_t) {}
+
+    class Scope {
+    public:
+        Scope(Operation, size_t) {}
+        Scope(Tier, size_t) {}
+    };
+#endif
+
+}
+
+#endif
@@ -0,0 +1,232 @@
+#include "Swap.hpp"
+#include "LongNum.hpp"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <initializer_list>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Every file-backed buffer is a file of its own, unlinked as soon as it is created, so the space
+// goes back to the file system when the buffer is freed or the process ends. The space is reserved
+// up front: a full disk makes the allocation throw std::bad_alloc instead of killing the process
+// with SIGBUS when a page is written back later.
+
+namespace {
+
+// Longest block, twice of it is the longest product of the number-theoretic transform
+constexpr size_t MAX_BLOCK = size_t(1) << 23;
+
+size_t pageSize(void) {
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+size_t roundToPages(size_t bytes) {
+    return (bytes + pageSize() - 1) / pageSize() * pageSize();
+}
+
+void advise(const uint32_t* p, size_t n, int advice) {
+    const uintptr_t start = reinterpret_cast<uintptr_t>(p) & ~(pageSize() - 1);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(p + n);
+    // Only a hint: ranges partly outside of a mapping or old kernels are not an error
+    ::madvise(reinterpret_cast<void*>(start), end - start, advice);
+}
+
+// Calls step(offset, length) for the blocks of [0, n), from the top down if `descending`. The next
+// block of every array is read ahead while one is processed, the finished one is evicted first
+template <typename Step>
+void stream(size_t n, size_t block, bool descending, std::initializer_list<const uint32_t*> arrays, Step step) {
+    const size_t count = (n + block - 1) / block;
+    for (size_t k = 0; k < count; k++) {
+        const size_t index = descending ? count - 1 - k : k;
+        const size_t offset = index * block;
+        const size_t length = std::min(block, n - offset);
+        if (k + 1 < count) {
+            const size_t next = (descending ? index - 1 : index + 1) * block;
+            for (const uint32_t* p : arrays) {
+                swap::willNeed(p + next, std::min(block, n - next));
+            }
+        }
+        step(offset, length);
+        for (const uint32_t* p : arrays) {
+            swap::evict(p + offset, length);
+        }
+    }
+}
+
+}
+
+// ****** Resource ******
+
+swap::Resource::Resource(std::string directory, size_t threshold, std::pmr::memory_resource* upstream)
+    : directory(std::move(directory)), threshold(threshold),
+      block(std::clamp(std::bit_floor(threshold / 16), MIN_BLOCK, MAX_BLOCK)), upstream(upstream) {
+    resources.fetch_add(1, std::memory_order_relaxed);
+}
+
+swap::Resource::~Resource() {
+    resources.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void* swap::Resource::do_allocate(size_t bytes, size_t alignment) {
+    if (bytes < threshold || alignment > pageSize()) {
+        return upstream ? upstream->allocate(bytes, alignment) : ::operator new(bytes, std::align_val_t(alignment));
+    }
+    const size_t size = roundToPages(bytes);
+    std::string path = directory + "/longnum-swap-XXXXXX";
+    const int fd = ::mkstemp(path.data());
+    if (fd < 0) {
+        throw std::bad_alloc();
+    }
+    ::unlink(path.c_str());
+    void* p = MAP_FAILED;
+    if (::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0) {
+        p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    const size_t current = mapped.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t highest = peak.load(std::memory_order_relaxed);
+    while (current > highest && !peak.compare_exchange_weak(highest, current, std::memory_order_relaxed)) {
+    }
+    return p;
+}
+
+void swap::Resource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    if (bytes < threshold || alignment > pageSize()) {
+        if (upstream) {
+            upstream->deallocate(p, bytes, alignment);
+        } else {
+            ::operator delete(p, std::align_val_t(alignment));
+        }
+        return;
+    }
+    const size_t size = roundToPages(bytes);
+    ::munmap(p, size);
+    mapped.fetch_sub(size, std::memory_order_relaxed);
+}
+
+size_t swap::currentBlock(void) {
+    const auto* resource = dynamic_cast<const Resource*>(limbs::currentResource);
+    return resource ? resource->blockLimbs() : 0;
+}
+
+void swap::willNeed(const uint32_t* p, size_t n) {
+    advise(p, n, MADV_WILLNEED);
+}
+
+void swap::evict(const uint32_t* p, size_t n) {
+#ifdef MADV_COLD
+    advise(p, n, MADV_COLD);
+#else
+    (void)p, (void)n;
+#endif
+}
+
+// ****** Streamed kernels ******
+
+uint32_t swap::streamedAddN(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n, uint32_t carry, size_t block) {
+    stream(n, block, false, {out, a, b}, [&](size_t offset, size_t length) {
+        carry = limbs::addN(out + offset, a + offset, b + offset, length, carry);
+    });
+    return carry;
+}
+
+uint32_t swap::streamedSubN(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n, uint32_t borrow, size_t block) {
+    stream(n, block, false, {out, a, b}, [&](size_t offset, size_t length) {
+        borrow = limbs::subN(out + offset, a + offset, b + offset, length, borrow);
+    });
+    return borrow;
+}
+
+uint32_t swap::streamedAdd1(uint32_t* out, const uint32_t* a, size_t n, uint32_t carry, size_t block) {
+    // In place the pass ends with the carry
+    if (out == a) {
+        return limbs::add1(out, a, n, carry);
+    }
+    stream(n, block, false, {out, a}, [&](size_t offset, size_t length) {
+        carry = limbs::add1(out + offset, a + offset, length, carry);
+    });
+    return carry;
+}
+
+uint32_t swap::streamedSub1(uint32_t* out, const uint32_t* a, size_t n, uint32_t borrow, size_t block) {
+    if (out == a) {
+        return limbs::sub1(out, a, n, borrow);
+    }
+    stream(n, block, false, {out, a}, [&](size_t offset, size_t length) {
+        borrow = limbs::sub1(out + offset, a + offset, length, borrow);
+    });
+    return borrow;
+}
+
+uint32_t swap::streamedLshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits, size_t block) {
+    // From the top down like the kernel, so the limb below a block is still that of a when it is
+    // shifted in
+    uint32_t high = 0;
+    stream(n, block, true, {out, a}, [&](size_t offset, size_t length) {
+        const uint32_t shifted = limbs::lshift(out + offset, a + offset, length, bits);
+        if (offset + length == n) {
+            high = shifted;
+        }
+        if (offset > 0) {
+            out[offset] |= static_cast<uint32_t>((static_cast<uint64_t>(a[offset - 1]) << bits) >> 32);
+        }
+    });
+    return high;
+}
+
+uint32_t swap::streamedRshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits, size_t block) {
+    uint32_t low = 0;
+    stream(n, block, false, {out, a}, [&](size_t offset, size_t length) {
+        const uint32_t shifted = limbs::rshift(out + offset, a + offset, length, bits);
+        if (offset == 0) {
+            low = shifted;
+        }
+        if (offset + length < n) {
+            out[offset + length - 1] |= static_cast<uint32_t>(static_cast<uint64_t>(a[offset + length]) << (32 - bits));
+        }
+    });
+    return low;
+}
+
+// ****** LongNum::ScopedSwap ******
+
+LongNum::ScopedSwap::ScopedSwap(const std::string& directory, size_t threshold) : previous(limbs::currentResource) {
+    struct stat info;
+    if (::stat(directory.c_str(), &info) != 0) {
+        throw std::system_error(errno, std::generic_category(), "Cannot use swap directory " + directory);
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        throw std::system_error(ENOTDIR, std::generic_category(), "Cannot use swap directory " + directory);
+    }
+    if (::access(directory.c_str(), W_OK | X_OK) != 0) {
+        throw std::system_error(errno, std::generic_category(), "Cannot use swap directory " + directory);
+    }
+    resource = std::make_unique<swap::Resource>(directory, threshold, previous);
+    limbs::currentResource = resource.get();
+}
+
+LongNum::ScopedSwap::~ScopedSwap() {
+    limbs::currentResource = previous;
+}
+
+size_t LongNum::ScopedSwap::mappedBytes(void) const {
+    return static_cast<const swap::Resource&>(*resource).mappedBytes();
+}
+
+size_t LongNum::ScopedSwap::peakBytes(void) const {
+    return static_cast<const swap::Resource&>(*resource).peakBytes();
+}
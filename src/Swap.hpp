@@ -0,0 +1,137 @@
+#ifndef SWAP_H
+#define SWAP_H
+#include "Allocator.hpp"
+#include "Limbs.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+// Out-of-core storage behind LongNum::ScopedSwap. Limb buffers from a threshold up are shared
+// mappings of files in a swap directory, so under memory pressure the kernel writes them back and
+// drops them instead of failing to allocate. The kernels below stand in for those of limbs:: in
+// the passes over whole numbers: while a swap resource is current, operands longer than one of its
+// blocks are processed a block at a time, with the next block read ahead and the finished ones
+// marked as the first to evict, so the I/O follows the pass instead of random page faults
+namespace swap {
+
+    // Shortest block, passes over fewer limbs are never split
+    constexpr size_t MIN_BLOCK = 64;
+
+    class Resource : public std::pmr::memory_resource {
+    public:
+        // Buffers of at least `threshold` bytes go to files in `directory`, the others to
+        // `upstream` (null for operator new)
+        Resource(std::string directory, size_t threshold, std::pmr::memory_resource* upstream);
+        ~Resource() override;
+
+        // Limbs of the blocks of the passes and of block multiplication. Buffers of two blocks
+        // stay below the threshold, so the products of blocks are computed in memory
+        size_t blockLimbs(void) const {
+            return block;
+        }
+        size_t mappedBytes(void) const {
+            return mapped.load(std::memory_order_relaxed);
+        }
+        size_t peakBytes(void) const {
+            return peak.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::string directory;
+        size_t threshold;
+        size_t block;
+        std::pmr::memory_resource* upstream;
+        std::atomic<size_t> mapped = 0;
+        std::atomic<size_t> peak = 0;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    // Swap resources alive in the process, so that passes do not look for one without them
+    inline std::atomic<unsigned> resources = 0;
+
+    // Block length of the swap resource current on this thread, 0 if there is none
+    size_t currentBlock(void);
+
+    // Block length to split a pass over n limbs by, 0 if it runs in one piece
+    inline size_t blockFor(size_t n) {
+        if (n <= MIN_BLOCK || resources.load(std::memory_order_relaxed) == 0) {
+            return 0;
+        }
+        const size_t block = currentBlock();
+        return n > block ? block : 0;
+    }
+
+    // Hints for the pages of p[0..n): read them ahead, or evict them before others when memory runs
+    // short. Neither changes the limbs
+    void willNeed(const uint32_t* p, size_t n);
+    void evict(const uint32_t* p, size_t n);
+
+    uint32_t streamedAddN(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n, uint32_t carry, size_t block);
+    uint32_t streamedSubN(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n, uint32_t borrow, size_t block);
+    uint32_t streamedAdd1(uint32_t* out, const uint32_t* a, size_t n, uint32_t carry, size_t block);
+    uint32_t streamedSub1(uint32_t* out, const uint32_t* a, size_t n, uint32_t borrow, size_t block);
+    uint32_t streamedLshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits, size_t block);
+    uint32_t streamedRshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits, size_t block);
+
+    // The kernels of limbs:: with the same contracts
+
+    inline uint32_t addN(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n, uint32_t carry = 0) {
+        if (const size_t block = blockFor(n)) {
+            return streamedAddN(out, a, b, n, carry, block);
+        }
+        return limbs::addN(out, a, b, n, carry);
+    }
+
+    inline uint32_t subN(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n, uint32_t borrow = 0) {
+        if (const size_t block = blockFor(n)) {
+            return streamedSubN(out, a, b, n, borrow, block);
+        }
+        return limbs::subN(out, a, b, n, borrow);
+    }
+
+    inline uint32_t add1(uint32_t* out, const uint32_t* a, size_t n, uint32_t carry) {
+        if (const size_t block = blockFor(n)) {
+            return streamedAdd1(out, a, n, carry, block);
+        }
+        return limbs::add1(out, a, n, carry);
+    }
+
+    inline uint32_t sub1(uint32_t* out, const uint32_t* a, size_t n, uint32_t borrow) {
+        if (const size_t block = blockFor(n)) {
+            return streamedSub1(out, a, n, borrow, block);
+        }
+        return limbs::sub1(out, a, n, borrow);
+    }
+
+    inline uint32_t lshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+        if (const size_t block = blockFor(n)) {
+            return streamedLshift(out, a, n, bits, block);
+        }
+        return limbs::lshift(out, a, n, bits);
+    }
+
+    inline uint32_t rshift(uint32_t* out, const uint32_t* a, size_t n, unsigned bits) {
+        if (const size_t block = blockFor(n)) {
+            return streamedRshift(out, a, n, bits, block);
+        }
+        return limbs::rshift(out, a, n, bits);
+    }
+
+    inline void addInto(uint32_t* out, size_t n, const uint32_t* x, size_t nx) {
+        add1(out + nx, out + nx, n - nx, addN(out, out, x, nx));
+    }
+
+    inline void subInto(uint32_t* out, size_t n, const uint32_t* x, size_t nx) {
+        sub1(out + nx, out + nx, n - nx, subN(out, out, x, nx));
+    }
+
+}
+
+#endif
@@ -1,45 +1,107 @@
-#include "LongNum.hpp"
-#include <iostream>
-#include <stdexcept>
-
-LongNum calculate_pi(const uint32_t precision) {
-    // https://www.craig-wood.com/nick/articles/pi-chudnovsky/
-    LongNum k = 1;
-    LongNum a_k(1.L,precision);
-    LongNum a_sum(1.L,precision);
-    LongNum b_sum = 0;
-    const LongNum C = 640320;
-    const LongNum C3_OVER_24 = C.pow(3) / 24;
-    while (a_k != 0) {
-        a_k *= -(6 * k - 5) * (2 * k - 1) * (6 * k - 1);
-        a_k /= k.pow(3) * C3_OVER_24;
-        a_sum += a_k;
-        b_sum += k * a_k;
-        k += 1;
-    }
-    LongNum total = a_sum * 13591409 + b_sum * 545140134;
-    LongNum pi = (426880 * (10005_longnum).withPrecision(precision).sqrt()) / total;
-    return pi;
-}
-
-int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Specify calculation precision by providing a command line argument\n";
-        return 1;
-    }
-    const std::string arg = argv[1];
-    try {
-        const int precision = std::stoi(arg);
-        if (precision <= 0) {
-            std::cerr << "Precision must be a positive\n";
-            return 1;
-        }
-        const LongNum pi = calculate_pi(std::max(380u, (unsigned)precision * 69 / 20 + 1));
-        std::cout << pi.toString(precision) << '\n';
-        return 0;
-    } catch (const std::invalid_argument& ex) {
-        std::cerr << "Wrong precision: " << arg << '\n';
-    } catch (const std::out_of_range& ex) {
-        std::cerr << "Precision out of range: " << arg << '\n';
-    }
-}
\ No newline at end of file
+#include "LongNum.hpp"
+#include "Pi.hpp"
+#include <iostream>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+// Smaller thresholds would put every limb buffer in a file of its own
+constexpr size_t MIN_SWAP_THRESHOLD = size_t(1) << 20;
+
+int main(int argc, char** argv) {
+    std::string arg;
+    unsigned threads = 1;
+    std::optional<LongNum::ScopedArena::Kind> arena;
+    bool stats = false;
+    std::string swapDir;
+    size_t swapThreshold = LongNum::ScopedSwap::DEFAULT_THRESHOLD;
+    for (int i = 1; i < argc; i++) {
+        const std::string current = argv[i];
+        if (current == "--threads" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            try {
+                const int count = std::stoi(value);
+                if (count <= 0) {
+                    throw std::invalid_argument(value);
+                }
+                threads = count;
+            } catch (const std::exception& ex) {
+                std::cerr << "Wrong thread count: " << value << '\n';
+                return 1;
+            }
+        } else if (current == "--arena" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            if (value == "bump") {
+                arena = LongNum::ScopedArena::Kind::Bump;
+            } else if (value == "pool") {
+                arena = LongNum::ScopedArena::Kind::Pool;
+            } else {
+                std::cerr << "Wrong arena kind: " << value << '\n';
+                return 1;
+            }
+        } else if (current == "--swap-dir" && i + 1 < argc) {
+            swapDir = argv[++i];
+        } else if (current == "--swap-threshold" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            try {
+                size_t end = 0;
+                swapThreshold = std::stoull(value, &end);
+                if (end != value.size() || swapThreshold < MIN_SWAP_THRESHOLD) {
+                    throw std::invalid_argument(value);
+                }
+            } catch (const std::exception& ex) {
+                std::cerr << "Wrong swap threshold: " << value << " (at least " << MIN_SWAP_THRESHOLD << " bytes)\n";
+                return 1;
+            }
+        } else if (current == "--stats") {
+            stats = true;
+        } else {
+            arg = current;
+        }
+    }
+    if (arg.empty()) {
+        std::cerr << "Specify calculation precision by providing a command line argument\n";
+        std::cerr << "Usage: calculate-pi [--threads N] [--arena bump|pool] [--swap-dir DIR [--swap-threshold BYTES]]"
+                     " [--stats] PRECISION\n";
+        return 1;
+    }
+    try {
+        const int precision = std::stoi(arg);
+        if (precision <= 0) {
+            std::cerr << "Precision must be a positive\n";
+            return 1;
+        }
+        LongNum::setThreads(threads);
+        std::optional<LongNum::ScopedArena> scope;
+        if (arena) {
+            scope.emplace(*arena);
+        }
+        // Buffers below the threshold still come from the arena
+        std::optional<LongNum::ScopedSwap> swap;
+        if (!swapDir.empty()) {
+            try {
+                swap.emplace(swapDir, swapThreshold);
+            } catch (const std::system_error& ex) {
+                std::cerr << ex.what() << '\n';
+                return 1;
+            }
+        }
+        const LongNum pi = calculate_pi(std::max(380u, (unsigned)precision * 69 / 20 + 1));
+        std::cout << pi.toString(precision) << '\n';
+        if (stats) {
+            // The digits go to stdout, so the statistics do not mix with them
+            std::cerr << LongNum::stats();
+        }
+        return 0;
+    } catch (const std::invalid_argument& ex) {
+        std::cerr << "Wrong precision: " << arg << '\n';
+    } catch (const std::out_of_range& ex) {
+        std::cerr << "Precision out of range: " << arg << '\n';
+    } catch (const std::bad_alloc& ex) {
+        // Also thrown when the swap directory runs out of disk space
+        std::cerr << "Out of memory" << (swapDir.empty() ? "" : " or disk space in " + swapDir) << '\n';
+        return 1;
+    }
+}
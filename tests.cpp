@@ -1,163 +1,727 @@
-#include "gtest/gtest.h"
-#include "src/LongNum.hpp"
-#include <limits>
-#include <cmath>
-
-// Тесты для конструкторов
-TEST(LongNumConstructorTest, DefaultConstructor) {
-    LongNum num(0.0L);
-    EXPECT_EQ(num.toString(), "0");
-}
-
-TEST(LongNumConstructorTest, LongDoubleConstructor) {
-    LongNum num(3.141592653589793238L);
-    EXPECT_EQ(num.toString(18), "3.141592653589793238");
-}
-
-TEST(LongNumConstructorTest, LongLongConstructor) {
-    LongNum num(1234567890123456789LL);
-    EXPECT_EQ(num.toString(), "1234567890123456789");
-}
-
-TEST(LongNumConstructorTest, UnsignedLongLongConstructor) {
-    LongNum num(12345678901234567890ULL);
-    EXPECT_EQ(num.toString(), "12345678901234567890");
-}
-
-// Тесты для операторов присваивания
-TEST(LongNumAssignmentTest, AssignmentOperator) {
-    LongNum num1(123.456L);
-    LongNum num2 = num1;
-    EXPECT_EQ(num2.toString(3), "123.456");
-}
-
-// Тесты для операторов сдвига
-TEST(LongNumShiftTest, LeftShift) {
-    LongNum num(1.0L);
-    num <<= 3;
-    EXPECT_EQ(num.toString(), "8");
-}
-
-TEST(LongNumShiftTest, RightShift) {
-    LongNum num(8.0L);
-    num >>= 3;
-    EXPECT_EQ(num.toString(), "1");
-}
-
-// Тесты для унарных операторов
-TEST(LongNumUnaryTest, UnaryPlus) {
-    LongNum num(-123.456L);
-    LongNum result = +num;
-    EXPECT_EQ(result.toString(3), "-123.456");
-}
-
-TEST(LongNumUnaryTest, UnaryMinus) {
-    LongNum num(123.456L);
-    LongNum result = -num;
-    EXPECT_EQ(result.toString(3), "-123.456");
-}
-
-// Тесты для арифметических операций
-TEST(LongNumArithmeticTest, Addition) {
-    LongNum num1(123.456L);
-    LongNum num2(654.321L);
-    LongNum result = num1 + num2;
-    EXPECT_EQ(result.toString(3), "777.777");
-}
-
-TEST(LongNumArithmeticTest, Subtraction) {
-    LongNum num1(654.321L);
-    LongNum num2(123.456L);
-    LongNum result = num1 - num2;
-    EXPECT_EQ(result.toString(3), "530.865");
-}
-
-TEST(LongNumArithmeticTest, Multiplication) {
-    LongNum num1(123.456L);
-    LongNum num2(2.0L);
-    LongNum result = num1 * num2;
-    EXPECT_EQ(result.toString(3), "246.912");
-}
-
-TEST(LongNumArithmeticTest, Division) {
-    LongNum num1(123.456L);
-    LongNum num2(2.0L);
-    LongNum result = num1 / num2;
-    EXPECT_EQ(result.toString(3), "61.728");
-}
-
-// Тесты для операторов сравнения
-TEST(LongNumComparisonTest, Equal) {
-    LongNum num1(123.456L);
-    LongNum num2(123.456L);
-    EXPECT_TRUE(num1 == num2);
-}
-
-TEST(LongNumComparisonTest, NotEqual) {
-    LongNum num1(123.456L);
-    LongNum num2(654.321L);
-    EXPECT_TRUE(num1 != num2);
-}
-
-TEST(LongNumComparisonTest, LessThan) {
-    LongNum num1(123.456L);
-    LongNum num2(654.321L);
-    EXPECT_TRUE(num1 < num2);
-}
-
-TEST(LongNumComparisonTest, GreaterThan) {
-    LongNum num1(654.321L);
-    LongNum num2(123.456L);
-    EXPECT_TRUE(num1 > num2);
-}
-
-// Тесты для работы с точностью
-TEST(LongNumPrecisionTest, SetPrecision) {
-    LongNum num(123.456L);
-    num.setPrecision(64);
-    EXPECT_EQ(num.getPrecision(), 64);
-}
-
-TEST(LongNumPrecisionTest, WithPrecision) {
-    LongNum num(123.456L);
-    LongNum result = num.withPrecision(32);
-    EXPECT_EQ(result.getPrecision(), 32);
-}
-
-// Тесты для метода toString
-TEST(LongNumToStringTest, ToString) {
-    LongNum num(123.456L);
-    EXPECT_EQ(num.toString(3), "123.456");
-}
-
-// Тесты для метода abs
-TEST(LongNumAbsTest, Abs) {
-    LongNum num(-123.456L);
-    LongNum result = num.abs();
-    EXPECT_EQ(result.toString(3), "123.456");
-}
-
-// Тесты для метода pow
-TEST(LongNumPowTest, Pow) {
-    LongNum num(2.0L);
-    LongNum result = num.pow(10);
-    EXPECT_EQ(result.toString(), "1024");
-}
-
-// Тесты для метода sqrt
-TEST(LongNumSqrtTest, Sqrt) {
-    LongNum num(16.0L);
-    LongNum result = num.sqrt();
-    EXPECT_EQ(result.toString(), "4");
-}
-
-// Тесты для литералов
-TEST(LongNumLiteralTest, LongDoubleLiteral) {
-    LongNum num = 123.456_longnum;
-    EXPECT_EQ(num.toString(3), "123.456");
-}
-
-TEST(LongNumLiteralTest, UnsignedLongLongLiteral) {
-    LongNum num = 1234567890_longnum;
-    EXPECT_EQ(num.toString(), "1234567890");
+#include "gtest/gtest.h"
+#include "src/LongNum.hpp"
+#include "src/Expression.hpp"
+#include "src/FixedLongNum.hpp"
+#include "src/LongNumView.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <cmath>
+
+// Тесты для конструкторов
+TEST(LongNumConstructorTest, DefaultConstructor) {
+    LongNum num(0.0L);
+    EXPECT_EQ(num.toString(), "0");
+}
+
+TEST(LongNumConstructorTest, LongDoubleConstructor) {
+    LongNum num(3.141592653589793238L);
+    EXPECT_EQ(num.toString(18), "3.141592653589793238");
+}
+
+TEST(LongNumConstructorTest, LongLongConstructor) {
+    LongNum num(1234567890123456789LL);
+    EXPECT_EQ(num.toString(), "1234567890123456789");
+}
+
+TEST(LongNumConstructorTest, UnsignedLongLongConstructor) {
+    LongNum num(12345678901234567890ULL);
+    EXPECT_EQ(num.toString(), "12345678901234567890");
+}
+
+TEST(LongNumConstructorTest, StringConstructor) {
+    EXPECT_EQ(LongNum("123.456", 64).toString(10), "123.4560000000");
+    EXPECT_EQ(LongNum("-0.5", 32).toString(), "-0.5");
+    EXPECT_EQ(LongNum("+42", 0).toString(), "42");
+    EXPECT_EQ(LongNum("-0", 0).toString(), "0");
+    EXPECT_EQ(LongNum(".25", 2).toString(), "0.25");
+    EXPECT_TRUE(LongNum("0.1", 32) == LongNum(0x1999999ALL).withPrecision(32) >> 32);
+    EXPECT_EQ(LongNum("0.99999999999", 32).toString(), "1");
+    EXPECT_THROW(LongNum("12a", 0), std::invalid_argument);
+    EXPECT_THROW(LongNum("", 0), std::invalid_argument);
+    EXPECT_THROW(LongNum("-.", 0), std::invalid_argument);
+}
+
+TEST(LongNumConstructorTest, StringConstructorLargeNumbers) {
+    EXPECT_TRUE(LongNum("1" + std::string(20000, '0'), 0) == (10_longnum).pow(20000));
+    std::string digits;
+    for (int i = 0; i < 30000; i++) {
+        digits += static_cast<char>('0' + (i * 7 + i / 13) % 10);
+    }
+    digits[0] = '9';
+    EXPECT_EQ(LongNum(digits, 0).toString(), digits);
+    EXPECT_EQ(LongNum("-12." + digits, 100000).toString(29990), "-12." + digits.substr(0, 29990));
+}
+
+TEST(LongNumConstructorTest, HexConstructor) {
+    EXPECT_EQ(LongNum("0xff.8", 32).toString(), "255.5");
+    EXPECT_EQ(LongNum::fromHex("-FFFFFFFFFFFFFFFFFFFFFFFF", 0).toString(), "-79228162514264337593543950335");
+    EXPECT_TRUE(LongNum::fromHex("1" + std::string(1000, '0'), 0) == (1_longnum << 4000));
+    EXPECT_THROW(LongNum::fromHex("0x1g", 0), std::invalid_argument);
+}
+
+// Тесты для операторов присваивания
+TEST(LongNumAssignmentTest, AssignmentOperator) {
+    LongNum num1(123.456L);
+    LongNum num2 = num1;
+    EXPECT_EQ(num2.toString(3), "123.456");
+}
+
+TEST(LongNumAssignmentTest, MoveAssignment) {
+    LongNum num1 = (3_longnum).pow(1000);
+    LongNum num2 = std::move(num1);
+    EXPECT_TRUE(num2 == (3_longnum).pow(1000));
+    num1 = -num2;
+    EXPECT_TRUE(num1 == -(3_longnum).pow(1000));
+}
+
+TEST(LongNumAssignmentTest, CompoundAssignment) {
+    LongNum num = 123.25_longnum;
+    num += num;
+    EXPECT_EQ(num.toString(), "246.5");
+    num -= 1000;
+    EXPECT_EQ(num.toString(), "-753.5");
+    num *= num;
+    EXPECT_EQ(num.toString(), "567762.25");
+    num /= -2;
+    num <<= 100;
+    num >>= 101;
+    EXPECT_EQ(num.toString(), "-141940.5625");
+    num -= num;
+    EXPECT_EQ(num.toString(), "0");
+    EXPECT_EQ(num.getPrecision(), 64u);
+}
+
+TEST(LongNumAssignmentTest, InlineAndHeapLimbs) {
+    // Up to a few limbs live inside the object, longer numbers on the heap
+    LongNum small = 13591409;
+    LongNum large = small << 1000;
+    LongNum copy = small;
+    copy = large;
+    EXPECT_TRUE(copy == large);
+    copy = small;
+    EXPECT_TRUE(copy == small);
+    LongNum moved = std::move(large);
+    EXPECT_TRUE((moved >> 1000) == small);
+    large = std::move(copy);
+    EXPECT_TRUE(large == small);
+    std::swap(large, moved);
+    EXPECT_TRUE(moved == small);
+    EXPECT_TRUE(large == small << 1000);
+}
+
+TEST(LongNumAssignmentTest, SharedLimbs) {
+    // Copies share the limbs until one of them changes
+    const LongNum x = LongNum(3LL).pow(1000).withPrecision(640) / 7;
+    const std::string expected = x.toString();
+    LongNum copy = x;
+    LongNum negated = -x;
+    LongNum truncated = x.withPrecision(64);
+    copy += 1;
+    negated <<= 33;
+    truncated.setPrecision(700);
+    truncated -= x;
+    EXPECT_EQ(x.toString(), expected);
+    EXPECT_TRUE(copy - 1 == x);
+    EXPECT_TRUE(negated.abs() >> 33 == x);
+    EXPECT_TRUE(truncated <= 0 && truncated > -(LongNum(1LL).withPrecision(64) >> 64));
+    LongNum views[] = {x, x.abs(), +x, x.withPrecision(0)};
+    views[0] >>= 100;
+    views[1].setPrecision(32);
+    views[2] *= views[3];
+    EXPECT_EQ(x.toString(), expected);
+    EXPECT_TRUE(views[1] == x.withPrecision(32) && views[3] == x.withPrecision(0));
+}
+
+TEST(LongNumAssignmentTest, ScopedArena) {
+    LongNum x = LongNum(3LL) << 2000;
+    LongNum expected = (x * x + x) / 7;
+    LongNum bump = 0LL;
+    LongNum pool = 0LL;
+    {
+        LongNum::ScopedArena arena(LongNum::ScopedArena::Kind::Bump);
+        bump = (x * x + x) / 7;
+        {
+            LongNum::ScopedArena nested;
+            pool = (x * x + x) / 7;
+        }
+        EXPECT_TRUE(pool == expected);
+    }
+    // The results were copied out of the arenas before they ended
+    EXPECT_TRUE(bump == expected);
+    EXPECT_TRUE(pool == expected);
+    bump += x;
+    EXPECT_TRUE(bump == expected + x);
+}
+
+TEST(LongNumAssignmentTest, ScopedSwap) {
+    const LongNum x = (3_longnum).pow(300000);
+    const LongNum y = (7_longnum).pow(120000).withPrecision(96) / 5;
+    const LongNum product = x * y;
+    const LongNum square = x * x;
+    const LongNum sum = (x << 37) + y - (x >> 45);
+    const LongNum quotient = x.withPrecision(320) / y;
+    LongNum results[4] = {0LL, 0LL, 0LL, 0LL};
+    {
+        // 64 KiB files and blocks of 4096 limbs: the operands take a few blocks
+        LongNum::ScopedSwap swap(testing::TempDir(), size_t(64) << 10);
+        const LongNum a = x + 0;
+        const LongNum b = y + 0;
+        results[0] = a * b;
+        results[1] = a * a;
+        results[2] = (a << 37) + b - (a >> 45);
+        results[3] = a.withPrecision(320) / b;
+        EXPECT_GT(swap.mappedBytes(), 0u);
+        EXPECT_GE(swap.peakBytes(), swap.mappedBytes());
+    }
+    EXPECT_TRUE(results[0] == product);
+    EXPECT_TRUE(results[1] == square);
+    EXPECT_TRUE(results[2] == sum);
+    EXPECT_TRUE(results[3] == quotient);
+    EXPECT_THROW(LongNum::ScopedSwap(testing::TempDir() + "no-such-directory"), std::system_error);
+}
+
+// Тесты для операторов сдвига
+TEST(LongNumShiftTest, LeftShift) {
+    LongNum num(1.0L);
+    num <<= 3;
+    EXPECT_EQ(num.toString(), "8");
+}
+
+TEST(LongNumShiftTest, RightShift) {
+    LongNum num(8.0L);
+    num >>= 3;
+    EXPECT_EQ(num.toString(), "1");
+}
+
+TEST(LongNumShiftTest, LongNumbers) {
+    // Long enough for the vector kernels, with lengths that leave a scalar tail
+    const LongNum one = 1LL;
+    for (uint32_t exponent : {700u, 1500u, 4001u}) {
+        const LongNum x = (LongNum(3LL).pow(exponent) << 3) + one;
+        for (uint32_t shift : {0u, 1u, 31u, 32u, 77u}) {
+            EXPECT_TRUE(((x << shift) >> shift) == x);
+            EXPECT_TRUE((x << shift) >> (shift + 1) == x >> 1);
+        }
+        EXPECT_TRUE(x == LongNum(x));
+        EXPECT_TRUE(x - one < x);
+        EXPECT_TRUE((x << 40) > (x << 39));
+        EXPECT_TRUE(-x < -(x - one));
+        EXPECT_TRUE(((x << 64) - (x << 64)) == 0);
+    }
+}
+
+// Тесты для унарных операторов
+TEST(LongNumUnaryTest, UnaryPlus) {
+    LongNum num(-123.456L);
+    LongNum result = +num;
+    EXPECT_EQ(result.toString(3), "-123.456");
+}
+
+TEST(LongNumUnaryTest, UnaryMinus) {
+    LongNum num(123.456L);
+    LongNum result = -num;
+    EXPECT_EQ(result.toString(3), "-123.456");
+}
+
+// Тесты для арифметических операций
+TEST(LongNumArithmeticTest, Addition) {
+    LongNum num1(123.456L);
+    LongNum num2(654.321L);
+    LongNum result = num1 + num2;
+    EXPECT_EQ(result.toString(3), "777.777");
+}
+
+TEST(LongNumArithmeticTest, Subtraction) {
+    LongNum num1(654.321L);
+    LongNum num2(123.456L);
+    LongNum result = num1 - num2;
+    EXPECT_EQ(result.toString(3), "530.865");
+}
+
+TEST(LongNumArithmeticTest, TemporaryOperands) {
+    LongNum num1 = 5.25_longnum;
+    LongNum num2 = -(2_longnum).pow(70);
+    EXPECT_TRUE((num1 + 0) + num2 == num1 + num2);
+    EXPECT_TRUE(num2 + (num1 + 0) == num1 + num2);
+    EXPECT_TRUE((num1 + 0) - num2 == num1 - num2);
+    EXPECT_TRUE(num2 - (num1 + 0) == num2 - num1);
+    EXPECT_TRUE(num1 - (num1 + 0) == 0);
+    EXPECT_TRUE((num1 * 2) - (num2 * 2) == (num1 - num2) * 2);
+    EXPECT_EQ((-(num1 * 2)).toString(), "-10.5");
+    EXPECT_EQ((num1 * -2).abs().toString(), "10.5");
+    EXPECT_EQ((num1 * 2).withPrecision(1).toString(), "10.5");
+    EXPECT_TRUE(((num1 * 4) >> 2) << 1 == num1 * 2);
+}
+
+TEST(LongNumArithmeticTest, Multiplication) {
+    LongNum num1(123.456L);
+    LongNum num2(2.0L);
+    LongNum result = num1 * num2;
+    EXPECT_EQ(result.toString(3), "246.912");
+}
+
+TEST(LongNumArithmeticTest, MultiplicationOfLargeNumbers) {
+    LongNum ones = (1_longnum << 40000) - 1;
+    LongNum expected = (1_longnum << 80000) - (1_longnum << 40001) + 1;
+    EXPECT_TRUE(ones * ones == expected);
+}
+
+TEST(LongNumArithmeticTest, MultiplicationNtt) {
+    // All limbs are 0xFFFFFFFF, the worst case for the size of convolution terms
+    LongNum ones = (1_longnum << 800000) - 1;
+    LongNum expected = (1_longnum << 1600000) - (1_longnum << 800001) + 1;
+    EXPECT_TRUE(ones * ones == expected);
+    EXPECT_TRUE((ones << 3) * (ones + 2) == ((expected + (ones << 1)) << 3));
+}
+
+TEST(LongNumArithmeticTest, MultiplicationAlgorithmsAgree) {
+    const LongNum::Thresholds defaults = LongNum::getThresholds();
+    LongNum num1 = (3_longnum).pow(30000) - 1;
+    LongNum num2 = -(7_longnum).pow(21000).withPrecision(96) + 0.5_longnum;
+    LongNum::setThresholds({1u << 30, 1u << 30, 1u << 30, 1u << 30});
+    LongNum schoolbook = num1 * num2;
+    LongNum::setThresholds({4, 8, 16, 1u << 30});
+    LongNum toomCook = num1 * num2;
+    LongNum::setThresholds({4, 8, 16, 8});
+    LongNum ntt = num1 * num2;
+    LongNum::setThresholds(defaults);
+    EXPECT_TRUE(schoolbook == toomCook);
+    EXPECT_TRUE(schoolbook == ntt);
+    EXPECT_TRUE(schoolbook == num1 * num2);
+    EXPECT_EQ((num1 * num2).getPrecision(), 96);
+}
+
+TEST(LongNumArithmeticTest, SquaringAlgorithmsAgree) {
+    // Squares of a number by itself take the squaring kernels, a copy goes through the general product
+    const LongNum::Thresholds defaults = LongNum::getThresholds();
+    const LongNum num = (3_longnum).pow(30000) - 1;
+    const LongNum copy = num;
+    LongNum::setThresholds({1u << 30, 1u << 30, 1u << 30, 1u << 30});
+    const LongNum expected = num * copy;
+    EXPECT_TRUE(num.square() == expected);
+    for (const LongNum::Thresholds& thresholds : {LongNum::Thresholds{4, 1u << 30, 1u << 30, 1u << 30},
+                                                  LongNum::Thresholds{4, 8, 1u << 30, 1u << 30},
+                                                  LongNum::Thresholds{4, 8, 16, 1u << 30},
+                                                  LongNum::Thresholds{4, 8, 16, 8}}) {
+        LongNum::setThresholds(thresholds);
+        EXPECT_TRUE(num * num == expected);
+    }
+    LongNum::setThresholds(defaults);
+    const LongNum fraction = LongNum("0.7071067811865475244008443621", 200);
+    EXPECT_TRUE(fraction.square() == fraction * LongNum(fraction));
+}
+
+TEST(LongNumArithmeticTest, ThreadsGiveSameResults) {
+    const LongNum::Thresholds defaults = LongNum::getThresholds();
+    LongNum num1 = (3_longnum).pow(60000) - 1;
+    LongNum num2 = -(7_longnum).pow(30000).withPrecision(96) + 0.5_longnum;
+    LongNum product = num1 * num2;
+    LongNum quotient = num1 / (num2 >> 20000);
+    std::string digits = num1.toString();
+    LongNum::setThreads(4);
+    EXPECT_EQ(LongNum::getThreads(), 4u);
+    EXPECT_TRUE(num1 * num2 == product);
+    EXPECT_TRUE(num1 / (num2 >> 20000) == quotient);
+    LongNum::setThresholds({4, 8, 16, 1u << 30});
+    EXPECT_TRUE(num1 * num2 == product);
+    LongNum::setThresholds(defaults);
+    EXPECT_EQ(num1.toString(), digits);
+    LongNum::setThreads(1);
+    EXPECT_THROW(LongNum::setThreads(0), std::invalid_argument);
+}
+
+TEST(LongNumArithmeticTest, MultiplicationOfUnalignedPrecision) {
+    LongNum num(1.5L, 16);
+    EXPECT_EQ((num * num).toString(), "2.25");
+    EXPECT_EQ((num * num).getPrecision(), 16u);
+    EXPECT_EQ((num * LongNum(0.25L, 40)).toString(), "0.375");
+}
+
+TEST(LongNumArithmeticTest, TruncatedMultiplication) {
+    // Short products must give exactly the truncated full product, in the schoolbook, Karatsuba
+    // and Toom ranges
+    const LongNum one = 1LL;
+    for (uint32_t limbs : {4u, 20u, 70u, 400u}) {
+        const LongNum third = ((one << (32 * limbs)) / 3).withPrecision(32 * limbs) >> (32 * limbs);
+        const LongNum ones = ((one << (32 * limbs)) - one).withPrecision(32 * limbs) >> (32 * limbs);
+        for (const LongNum& x : {third, ones}) {
+            const LongNum product = x * (x + 5);
+            const LongNum full = (x.withPrecision(64 * limbs) * (x + 5).withPrecision(64 * limbs));
+            EXPECT_TRUE(product == full.withPrecision(32 * limbs));
+            EXPECT_TRUE(LongNum::mulTruncated(x, x, 32 * limbs - 40) == (x * x).withPrecision(32 * limbs - 40));
+            EXPECT_EQ(LongNum::mulTruncated(x, x, 96 * limbs).getPrecision(), 96 * limbs);
+        }
+    }
+}
+
+TEST(LongNumArithmeticTest, CarryPropagation) {
+    // All-ones numbers of odd and even limb counts carry through every limb
+    const LongNum one = 1LL;
+    for (uint32_t limbs : {1u, 2u, 5u, 8u, 31u}) {
+        const LongNum ones = (one << (32 * limbs)) - one;
+        EXPECT_TRUE(ones + one == one << (32 * limbs));
+        EXPECT_TRUE(ones * ones == (one << (64 * limbs)) - (one << (32 * limbs + 1)) + one);
+        EXPECT_TRUE(one - (ones << 1) == -(ones + ones - one));
+    }
+    LongNum fraction(0.25L, 64);
+    EXPECT_EQ((fraction - LongNum("4294967296.5", 32)).toString(), "-4294967296.25");
+}
+
+TEST(LongNumArithmeticTest, Division) {
+    LongNum num1(123.456L);
+    LongNum num2(2.0L);
+    LongNum result = num1 / num2;
+    EXPECT_EQ(result.toString(3), "61.728");
+}
+
+TEST(LongNumArithmeticTest, DivisionOfLargeNumbers) {
+    const LongNum::Thresholds defaults = LongNum::getThresholds();
+    LongNum num1 = (3_longnum).pow(60000) + 12345;
+    LongNum num2 = (7_longnum).pow(20000) - 1;
+    for (size_t threshold : {defaults.newtonDivision, size_t(4), size_t(1) << 30}) {
+        LongNum::Thresholds thresholds = defaults;
+        thresholds.newtonDivision = threshold;
+        LongNum::setThresholds(thresholds);
+        LongNum quotient = num1 / num2;
+        LongNum remainder = num1 - quotient * num2;
+        EXPECT_FALSE(remainder < 0);
+        EXPECT_TRUE(remainder < num2);
+    }
+    LongNum::setThresholds(defaults);
+}
+
+TEST(LongNumArithmeticTest, DivisionKeepsPrecision) {
+    LongNum result = (1_longnum).withPrecision(32) / (3_longnum);
+    EXPECT_EQ(result.getPrecision(), 32);
+    EXPECT_TRUE(result == (LongNum(0x55555555LL).withPrecision(32) >> 32));
+    EXPECT_EQ((-7_longnum / 2_longnum).toString(), "-3");
+    EXPECT_THROW(1_longnum / (-1_longnum / 2_longnum), std::invalid_argument);
+}
+
+TEST(LongNumArithmeticTest, NativeIntegerOperands) {
+    // Mixed operations agree with converting the integer first, also for 64-bit magnitudes
+    const LongNum x("-123456789012345678901234567890.625", 64);
+    for (long long n : {0LL, 1LL, -7LL, 4294967296LL, -1537228672809129000LL}) {
+        EXPECT_TRUE(x + n == x + LongNum(n));
+        EXPECT_TRUE(n - x == LongNum(n) - x);
+        EXPECT_TRUE(x * n == x * LongNum(n));
+        if (n != 0) {
+            EXPECT_TRUE(x / n == x / LongNum(n));
+        }
+    }
+    EXPECT_EQ((x * 18446744073709551615ULL).toString(), (x * LongNum(18446744073709551615ULL)).toString());
+    EXPECT_EQ((LongNum("100.5", 32) % 7).toString(), "2.5");
+    EXPECT_EQ((LongNum("-100.5", 32) % -7).toString(), "-2.5");
+    EXPECT_EQ((x % 10000000000LL).toString(), "-1234567890.625");
+    EXPECT_THROW(x / 0, std::invalid_argument);
+    EXPECT_THROW(x % 0u, std::invalid_argument);
+}
+
+TEST(LongNumArithmeticTest, Divisor) {
+    // Single-limb, multi-limb and Newton-sized divisors agree with operator/
+    const LongNum big = LongNum(3LL).pow(40000) + 1;
+    const std::vector<LongNum> divisors = {LongNum(-7LL), LongNum("0.75", 32), LongNum(1LL) << 100,
+                                           LongNum("-98765432109876543210987654321.125", 64), big};
+    const std::vector<LongNum> numbers = {LongNum("123456789012345678901234567890.5", 32), LongNum(-1LL),
+                                          LongNum(7LL).pow(50000).withPrecision(96), LongNum(0LL)};
+    for (const LongNum& d : divisors) {
+        const LongNum::Divisor divisor(d);
+        for (const LongNum& x : numbers) {
+            EXPECT_TRUE(divisor.divide(x) == x / d);
+            auto [q, r] = divisor.divmod(x);
+            EXPECT_TRUE((q - (x / d).withPrecision(0)).isZero());
+            EXPECT_TRUE(q * d + r == x);
+            EXPECT_TRUE(r.abs() < d.abs());
+        }
+    }
+    const LongNum::Divisor seven(7LL);
+    EXPECT_EQ(seven.quotient(LongNum(-100LL)).toString(), "-14");
+    EXPECT_EQ(seven.remainder(LongNum(-100LL)).toString(), "-2");
+    EXPECT_THROW(LongNum::Divisor(LongNum(0LL)), std::invalid_argument);
+}
+
+// Тесты для операторов сравнения
+TEST(LongNumComparisonTest, Equal) {
+    LongNum num1(123.456L);
+    LongNum num2(123.456L);
+    EXPECT_TRUE(num1 == num2);
+}
+
+TEST(LongNumComparisonTest, NotEqual) {
+    LongNum num1(123.456L);
+    LongNum num2(654.321L);
+    EXPECT_TRUE(num1 != num2);
+}
+
+TEST(LongNumComparisonTest, LessThan) {
+    LongNum num1(123.456L);
+    LongNum num2(654.321L);
+    EXPECT_TRUE(num1 < num2);
+}
+
+TEST(LongNumComparisonTest, GreaterThan) {
+    LongNum num1(654.321L);
+    LongNum num2(123.456L);
+    EXPECT_TRUE(num1 > num2);
+}
+
+TEST(LongNumComparisonTest, DifferentPrecisions) {
+    // The extra fractional limbs of the longer operand decide when the common limbs are equal
+    const LongNum half(0.5L, 32);
+    const LongNum justAbove = LongNum(0.5L, 96) + (LongNum(1LL).withPrecision(96) >> 90);
+    EXPECT_TRUE(half < justAbove);
+    EXPECT_TRUE(justAbove > half);
+    EXPECT_TRUE(half == LongNum(0.5L, 96));
+    EXPECT_TRUE(-justAbove < -half);
+    EXPECT_TRUE((LongNum(3LL) << 70) > (LongNum(3.75L, 64) << 69));
+}
+
+TEST(LongNumComparisonTest, NativeIntegers) {
+    const LongNum big = LongNum(1LL) << 70;
+    EXPECT_TRUE(big > UINT64_MAX);
+    EXPECT_TRUE(-big < INT64_MIN);
+    EXPECT_TRUE(LongNum(0.5L, 32) > 0 && LongNum(0.5L, 32) < 1);
+    EXPECT_TRUE(LongNum(-3LL) == -3 && -3 == LongNum(-3LL) && LongNum(-3LL) != 3u);
+    LongNum negativeZero = LongNum(-1LL) / 3;
+    EXPECT_TRUE(negativeZero.isZero());
+    EXPECT_EQ(negativeZero.sign(), 0);
+    EXPECT_EQ(LongNum(0.25L, 32).sign(), 1);
+    EXPECT_EQ((-big).sign(), -1);
+}
+
+// Тесты для работы с точностью
+TEST(LongNumPrecisionTest, SetPrecision) {
+    LongNum num(123.456L);
+    num.setPrecision(64);
+    EXPECT_EQ(num.getPrecision(), 64);
+}
+
+TEST(LongNumPrecisionTest, WithPrecision) {
+    LongNum num(123.456L);
+    LongNum result = num.withPrecision(32);
+    EXPECT_EQ(result.getPrecision(), 32);
+}
+
+// Тесты для метода toString
+TEST(LongNumToStringTest, ToString) {
+    LongNum num(123.456L);
+    EXPECT_EQ(num.toString(3), "123.456");
+}
+
+TEST(LongNumToStringTest, ToStringLargeNumbers) {
+    EXPECT_EQ((1_longnum << 200).toString(), "1606938044258990275541962092341162602522202993782792835301376");
+    EXPECT_EQ((10_longnum).pow(5000).toString(), "1" + std::string(5000, '0'));
+
+    // 2^-3000 = 5^3000 / 10^3000
+    LongNum fraction = (1_longnum).withPrecision(3008) >> 3000;
+    std::string digits = (5_longnum).pow(3000).toString();
+    digits.insert(0, 3000 - digits.size(), '0');
+    EXPECT_EQ(fraction.toString(), "0." + digits);
+    EXPECT_EQ((-fraction).toString(2500), "-0." + digits.substr(0, 2500));
+}
+
+TEST(LongNumToStringTest, BinaryRoundTrip) {
+    const LongNum values[] = {0_longnum, -0_longnum, -(3_longnum).pow(700), (2_longnum).withPrecision(100).sqrt(),
+                              -(1_longnum).withPrecision(640) / 3};
+    for (const LongNum& x : values) {
+        std::stringstream stream;
+        x.write(stream);
+        const LongNum y = LongNum::read(stream);
+        EXPECT_EQ(y.getPrecision(), x.getPrecision());
+        EXPECT_EQ(y.toString(), x.toString());
+    }
+
+    const LongNum x = (7_longnum).pow(3000).withPrecision(96) / 11;
+    std::stringstream stream;
+    x.write(stream);
+    std::string bytes = stream.str();
+    EXPECT_TRUE(bytes.size() % 4 == 0 && bytes.size() < x.toString().size() / 2);
+    for (size_t at : {size_t(0), size_t(6), size_t(40), bytes.size() - 1}) {
+        std::string corrupted = bytes;
+        corrupted[at] ^= 4;
+        std::istringstream in(corrupted);
+        EXPECT_THROW(LongNum::read(in), std::invalid_argument);
+    }
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 9));
+    EXPECT_THROW(LongNum::read(truncated), std::invalid_argument);
+    std::string wide = bytes;
+    wide[11] = '\x80';
+    std::istringstream widePrecision(wide);
+    try {
+        LongNum::read(widePrecision);
+        ADD_FAILURE() << "A precision above INT_MAX was accepted";
+    } catch (const std::invalid_argument& error) {
+        EXPECT_NE(std::string(error.what()).find("out of range"), std::string::npos);
+    }
+
+    // A mapped file is used in place, and copies of it outlive the view
+    const std::string path = testing::TempDir() + "longnum-binary-test.bin";
+    std::ofstream(path, std::ios::binary) << bytes;
+    LongNum copy = 0LL;
+    {
+        const LongNumView view(path);
+        EXPECT_TRUE(view.verify());
+        EXPECT_TRUE(view.value() == x);
+        EXPECT_TRUE(view.value() * 11 - x * 11 == 0);
+        copy = view.value();
+    }
+    copy += 1;
+    EXPECT_TRUE(copy - 1 == x);
+    std::ofstream(path, std::ios::binary) << bytes.substr(0, 30);
+    EXPECT_THROW(LongNumView{path}, std::invalid_argument);
+    std::remove(path.c_str());
+    EXPECT_THROW(LongNumView{path}, std::system_error);
+}
+
+// Тесты для метода abs
+TEST(LongNumAbsTest, Abs) {
+    LongNum num(-123.456L);
+    LongNum result = num.abs();
+    EXPECT_EQ(result.toString(3), "123.456");
+}
+
+TEST(LongNumExpressionTest, MatchesOperators) {
+    using expr::lazy;
+    const LongNum a = LongNum(3LL).pow(700) + LongNum("0.75", 64);
+    const LongNum b = -LongNum(7LL).pow(300);
+    const LongNum c("-123456789.5", 32);
+    for (long long n : {0LL, -1LL, 13591409LL, 4294967295LL, -1537228672809129000LL}) {
+        EXPECT_TRUE(LongNum(lazy(a) * n + lazy(b) * 545140134) == a * n + b * 545140134);
+        EXPECT_TRUE(LongNum(lazy(a) * b * c - n * lazy(c)) == a * b * c - n * c);
+        EXPECT_TRUE(LongNum(-(lazy(6 * n - 5) * (2 * n - 1) * (6 * n - 1))) == -(LongNum(6 * n - 5) * (2 * n - 1) * (6 * n - 1)));
+        // Temporaries on either side are taken by the expression, not converted into it
+        EXPECT_TRUE(LongNum(lazy(a) * 3 + b * c) == a * 3 + b * c);
+        EXPECT_TRUE(LongNum(b * c - lazy(a) * n) == b * c - a * n);
+        EXPECT_TRUE(LongNum(lazy(a) * n - LongNum(n)) == a * n - n);
+        LongNum x = c;
+        x += lazy(a) * n;
+        EXPECT_TRUE(x == c + a * n);
+        // The product is larger than x and has the other sign
+        x = c;
+        x -= lazy(b) * 3 * n;
+        EXPECT_TRUE(x == c - b * 3 * n);
+        x += lazy(x) * b;
+        EXPECT_TRUE(x == (c - b * 3 * n) * (1 + b));
+    }
+}
+
+TEST(LongNumFixedTest, MatchesLongNum) {
+    using Fixed = FixedLongNum<64, 64>;
+    using Narrow = FixedLongNum<20, 44>;
+    using Wide = FixedLongNum<128, 128>;
+    static_assert(Fixed(3) * Fixed(-7) == Fixed(-21));
+    static_assert(Fixed(1) / Fixed(4) < Fixed(1) && (Fixed(1) / Fixed(4)).raw()[0] == uint64_t(1) << 62);
+    const LongNum a("-12345678.90625", 64);
+    const LongNum b("0.3333333333333333333", 64);
+    const Fixed fa(a), fb(b);
+    EXPECT_TRUE(LongNum(fa) == a);
+    EXPECT_TRUE(LongNum(fa + fb) == a + b);
+    EXPECT_TRUE(LongNum(fa - fb) == a - b);
+    EXPECT_TRUE(LongNum(fa * fb) == a * b);
+    EXPECT_TRUE(LongNum(fa / fb) == (a / b).withPrecision(64));
+    EXPECT_TRUE(fb < fa.abs() && -fa > fb);
+    EXPECT_EQ(Narrow(LongNum("-2.75", 32)).toString(), "-2.75");
+    EXPECT_EQ(Wide(LongNum(3LL).pow(80)).toString(), LongNum(3LL).pow(80).toString());
+    EXPECT_NO_THROW(Fixed(-(LongNum(1LL) << 63)));
+    EXPECT_THROW(Fixed(LongNum(1LL) << 63), std::out_of_range);
+    EXPECT_THROW(fa / Fixed(0), std::invalid_argument);
+}
+
+TEST(LongNumFixedTest, MinimumOfNarrowType) {
+    // The most negative value is its own negation, its magnitude needs the sign bit
+    using Byte = FixedLongNum<8, 0>;
+    using Narrow = FixedLongNum<20, 12>;
+    EXPECT_EQ(Byte(-128).toString(), "-128");
+    EXPECT_TRUE(LongNum(Byte(-128) / Byte(2)) == LongNum(-64LL));
+    EXPECT_TRUE(LongNum(Byte(-128) * Byte(1)) == LongNum(-128LL));
+    const LongNum minimum = -(LongNum(1LL) << 19);
+    EXPECT_TRUE(LongNum(Narrow(minimum)) == minimum);
+    EXPECT_EQ(Narrow(minimum).toString(), "-524288");
+    EXPECT_TRUE(LongNum(Narrow(minimum) / Narrow(-4)) == (LongNum(1LL) << 17));
+}
+
+TEST(LongNumStatsTest, CountsOperations) {
+    const LongNum a = LongNum(3LL).pow(2000);
+    const LongNum b = LongNum(7LL).pow(900);
+    LongNum::resetStats();
+    const LongNum product = a * b;
+    const LongNum quotient = product / b;
+    const LongNum::Stats counters = LongNum::stats();
+    if (!counters.enabled) {
+        EXPECT_EQ(counters[stats::Operation::Multiply].calls, 0u);
+        EXPECT_EQ(counters.allocations, 0u);
+        return;
+    }
+    EXPECT_EQ(counters[stats::Operation::Multiply].calls, 1u);
+    EXPECT_EQ(counters[stats::Operation::Divide].calls, 1u);
+    EXPECT_EQ(counters[stats::Operation::Multiply].limbs, 100u + 79u);
+    EXPECT_GE(counters[stats::Tier::Karatsuba].calls, 1u);
+    EXPECT_GE(counters[stats::Tier::LongDivision].calls, 1u);
+    EXPECT_EQ(counters[stats::Operation::Pow].calls, 0u);
+    EXPECT_GE(counters.allocations, 2u);
+    EXPECT_GE(counters.peakBytes, counters.currentBytes);
+    EXPECT_TRUE(quotient == a);
+    LongNum::resetStats();
+    EXPECT_EQ(LongNum::stats()[stats::Operation::Multiply].calls, 0u);
+}
+
+// Тесты для метода pow
+TEST(LongNumPowTest, Pow) {
+    LongNum num(2.0L);
+    LongNum result = num.pow(10);
+    EXPECT_EQ(result.toString(), "1024");
+}
+
+TEST(LongNumPowTest, SlidingWindow) {
+    // Exponents with every window size and gaps of zero bits between the windows
+    const LongNum base = -3LL;
+    LongNum expected = 1LL;
+    for (uint32_t power = 0; power <= 300; power++) {
+        EXPECT_TRUE(base.pow(power) == expected);
+        expected *= base;
+    }
+    EXPECT_TRUE((7_longnum).pow(40961) == (7_longnum).pow(40960) * 7);
+    EXPECT_TRUE((5_longnum).pow(1u << 17) == (5_longnum).pow(1u << 16).square());
+    EXPECT_EQ((0.5_longnum).pow(3).toString(), "0.125");
+}
+
+// Тесты для метода sqrt
+TEST(LongNumSqrtTest, Sqrt) {
+    LongNum num(16.0L);
+    LongNum result = num.sqrt();
+    EXPECT_EQ(result.toString(), "4");
+}
+
+TEST(LongNumSqrtTest, TruncatedToPrecision) {
+    EXPECT_EQ(LongNum(3LL).sqrt().toString(), "1");
+    EXPECT_EQ(LongNum(2LL).withPrecision(200).sqrt().toString(50), "1.41421356237309504880168872420969807856967187537694");
+    EXPECT_EQ(LongNum(0.25L, 32).sqrt().toString(), "0.5");
+    EXPECT_EQ(LongNum(2LL).withPrecision(200).sqrt().getPrecision(), 200u);
+    EXPECT_THROW(LongNum(-1LL).sqrt(), std::invalid_argument);
+}
+
+TEST(LongNumSqrtTest, SqrtRem) {
+    // Perfect squares, their neighbours and numbers of many limbs
+    const LongNum big = (7_longnum).pow(5001);
+    for (const LongNum& n : {LongNum(0LL), LongNum(1LL), LongNum(99LL), big, big.square(), big.square() - 1, big.square() + big * 2}) {
+        const auto [root, remainder] = n.sqrtRem();
+        EXPECT_TRUE(root.square() + remainder == n);
+        EXPECT_TRUE(remainder >= 0 && remainder <= root * 2);
+        EXPECT_TRUE(n.isqrt() == root);
+    }
+    EXPECT_TRUE(big.square().isqrt() == big);
+    EXPECT_TRUE(LongNum("99.99", 64).isqrt() == 9);
+}
+
+// Тесты для литералов
+TEST(LongNumLiteralTest, LongDoubleLiteral) {
+    LongNum num = 123.456_longnum;
+    EXPECT_EQ(num.toString(3), "123.456");
+}
+
+TEST(LongNumLiteralTest, UnsignedLongLongLiteral) {
+    LongNum num = 1234567890_longnum;
+    EXPECT_EQ(num.toString(), "1234567890");
 }
\ No newline at end of file